@@ -0,0 +1,364 @@
+/**
+ * @brief tf2_bench: throughput and latency benchmark of a tf2 model.
+ *
+ * Loads the model of an input file through `tf2::model` and sweeps the
+ * number of points per call, the batch size, the data precision, the
+ * major ordering (with the column-major conversion done on the host or
+ * in the graph) and the number of session threads. For each setting,
+ * the points per second and the p50/p99 call latencies are reported as
+ * JSON. When both column-major layouts are run, the report also compares
+ * the conversion in the graph (`"transpose_in_graph"`) with the one on
+ * the host, setting by setting. With a baseline file (a previous report),
+ * the settings whose throughput or median latency regressed beyond the
+ * tolerance are listed, and the exit status is 2.
+ *
+ * Usage: tf2_bench --input <file> [--nb-pts <list>] [--batch-size <list>]
+ *          [--dtype <list>] [--layout <list>] [--threads <list>]
+ *          [--reps <n>] [--warmup <n>] [--output <file>]
+ *          [--baseline <file>] [--tolerance <x>]
+ *
+ * Lists are comma-separated. The defaults are: --nb-pts 1,100,10000,
+ * --batch-size -1 (no batches), --dtype float,double, --layout
+ * row,col,col-graph, --threads 0 (TensorFlow default), --reps 50,
+ * --warmup 5 and --tolerance 0.1.
+ */
+#include <map>
+#include <random>
+#include <chrono>
+#include <numeric>
+#include <algorithm>
+#include <filesystem>
+#include <unistd.h>
+#include <nlohmann/json.hpp>
+#include "tf2.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+  // Command line
+  // ====================================
+  struct options {
+    std::string input;
+    std::vector<std::int32_t> nb_pts = {1, 100, 10000};
+    std::vector<std::int32_t> batch_size = {-1};
+    std::vector<std::string> dtype = {"float", "double"};
+    std::vector<std::string> layout = {"row", "col", "col-graph"};
+    std::vector<std::int32_t> threads = {0};
+    std::int32_t reps = 50;
+    std::int32_t warmup = 5;
+    std::string output;
+    std::string baseline;
+    double tolerance = 0.1;
+  };
+
+  std::vector<std::string> split(const std::string& list) {
+    std::vector<std::string> items;
+    std::istringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+      if (!item.empty()) {
+        items.push_back(item);
+      }
+    }
+    return items;
+  }
+
+  std::vector<std::int32_t> split_int(const std::string& list) {
+    std::vector<std::int32_t> items;
+    for (const auto &item : split(list)) {
+      items.push_back(std::stoi(item));
+    }
+    return items;
+  }
+
+  options parse_options(int argc, char** argv) {
+    options opts;
+    for (int i = 1; i < argc; ++i) {
+      const std::string arg = argv[i];
+      if ((arg.rfind("--", 0) != 0) || (i + 1 >= argc)) {
+        throw std::invalid_argument("Invalid option '" + arg + "'.");
+      }
+      const std::string value = argv[++i];
+      if (arg == "--input") {
+        opts.input = value;
+      } else if (arg == "--nb-pts") {
+        opts.nb_pts = split_int(value);
+      } else if (arg == "--batch-size") {
+        opts.batch_size = split_int(value);
+      } else if (arg == "--dtype") {
+        opts.dtype = split(value);
+      } else if (arg == "--layout") {
+        opts.layout = split(value);
+      } else if (arg == "--threads") {
+        opts.threads = split_int(value);
+      } else if (arg == "--reps") {
+        opts.reps = std::stoi(value);
+      } else if (arg == "--warmup") {
+        opts.warmup = std::stoi(value);
+      } else if (arg == "--output") {
+        opts.output = value;
+      } else if (arg == "--baseline") {
+        opts.baseline = value;
+      } else if (arg == "--tolerance") {
+        opts.tolerance = std::stod(value);
+      } else {
+        throw std::invalid_argument("Unknown option '" + arg + "'.");
+      }
+    }
+    if (opts.input.empty()) {
+      throw std::invalid_argument("The input file is required (--input).");
+    }
+    if (opts.reps < 1) {
+      throw std::invalid_argument("The number of repetitions must be positive.");
+    }
+    for (const auto &d : opts.dtype) {
+      if ((d != "float") && (d != "double")) {
+        throw std::invalid_argument("Unknown dtype '" + d + "'.");
+      }
+    }
+    for (const auto &l : opts.layout) {
+      if ((l != "row") && (l != "col") && (l != "col-graph")) {
+        throw std::invalid_argument("Unknown layout '" + l + "'.");
+      }
+    }
+    return opts;
+  }
+
+  // Benchmark
+  // ====================================
+  struct setting {
+    std::string dtype;
+    std::string layout;
+    std::int32_t batch_size;
+    std::int32_t threads;
+    std::int32_t nb_pts;
+
+    // Key of the setting in the reports
+    std::string key() const {
+      std::ostringstream k;
+      k << this->dtype << "/" << this->layout << "/bs" << this->batch_size
+        << "/t" << this->threads << "/n" << this->nb_pts;
+      return k.str();
+    }
+  };
+
+  double quantile(std::vector<double> values, const double q) {
+    std::sort(values.begin(), values.end());
+    const std::size_t k = static_cast<std::size_t>(
+      q * static_cast<double>(values.size() - 1) + 0.5
+    );
+    return values[std::min(k, values.size() - 1)];
+  }
+
+  template <typename T>
+  json run(
+    tf2::model& mdl,
+    const setting& s,
+    const options& opts
+  ) {
+    // Synthetic inputs
+    std::mt19937 gen(1234);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    const std::size_t n = static_cast<std::size_t>(s.nb_pts);
+    std::vector<T> x(n * mdl.inp_tot_dim), y(n * mdl.out_tot_dim);
+    for (auto &v : x) {
+      v = static_cast<T>(dist(gen));
+    }
+    // Warm-up and timed calls
+    for (std::int32_t r = 0; r < opts.warmup; ++r) {
+      mdl.call<T>(x.data(), y.data(), s.nb_pts);
+    }
+    std::vector<double> latencies;
+    for (std::int32_t r = 0; r < opts.reps; ++r) {
+      const auto t0 = std::chrono::steady_clock::now();
+      mdl.call<T>(x.data(), y.data(), s.nb_pts);
+      const std::chrono::duration<double> dt =
+        std::chrono::steady_clock::now() - t0;
+      latencies.push_back(dt.count());
+    }
+    const double total = std::accumulate(
+      latencies.begin(), latencies.end(), 0.0
+    );
+    return {
+      {"key", s.key()},
+      {"dtype", s.dtype},
+      {"layout", s.layout},
+      {"batch_size", s.batch_size},
+      {"threads", s.threads},
+      {"nb_pts", s.nb_pts},
+      {"pts_per_sec", s.nb_pts * opts.reps / total},
+      {"p50_us", 1.0e6 * quantile(latencies, 0.50)},
+      {"p99_us", 1.0e6 * quantile(latencies, 0.99)}
+    };
+  }
+
+  // Input file of a model setting
+  std::string write_input(
+    const json& base,
+    const std::string& layout,
+    const std::int32_t batch_size,
+    const std::int32_t threads
+  ) {
+    json inputs = base;
+    inputs["rowmajor"] = (layout == "row");
+    inputs["transpose_in_graph"] = (layout == "col-graph");
+    inputs["batch_size"] = batch_size;
+    inputs.erase("warmup");
+    if (threads > 0) {
+      inputs["intra_op_threads"] = threads;
+    }
+    const std::filesystem::path path =
+      std::filesystem::temp_directory_path() /
+      ("tf2_bench_" + std::to_string(::getpid()) + ".json");
+    std::ofstream(path) << inputs.dump();
+    return path.string();
+  }
+
+  // Column-major conversion in the graph against the one on the host:
+  // ratios of the throughputs and median latencies of each setting
+  json compare_layouts(
+    const json& results
+  ) {
+    std::map<std::string, json> host;
+    for (const auto &r : results) {
+      if (r["layout"] == "col") {
+        setting s = {
+          r["dtype"], "col-graph", r["batch_size"], r["threads"], r["nb_pts"]
+        };
+        host[s.key()] = r;
+      }
+    }
+    json ratios = json::array();
+    for (const auto &r : results) {
+      const auto it = host.find(r["key"].get<std::string>());
+      if ((r["layout"] != "col-graph") || (it == host.end())) {
+        continue;
+      }
+      const json& h = it->second;
+      ratios.push_back({
+        {"key", r["key"]},
+        {"speedup", r["pts_per_sec"].get<double>() /
+          h["pts_per_sec"].get<double>()},
+        {"p50_ratio", r["p50_us"].get<double>() / h["p50_us"].get<double>()}
+      });
+    }
+    return ratios;
+  }
+
+  // Settings of the report slower than the baseline
+  std::vector<std::string> compare(
+    const json& report,
+    const json& baseline,
+    const double tolerance
+  ) {
+    std::map<std::string, json> reference;
+    for (const auto &r : baseline["results"]) {
+      reference[r["key"].get<std::string>()] = r;
+    }
+    std::vector<std::string> regressions;
+    for (const auto &r : report["results"]) {
+      const auto it = reference.find(r["key"].get<std::string>());
+      if (it == reference.end()) {
+        continue;
+      }
+      const json& b = it->second;
+      const double rate = r["pts_per_sec"], b_rate = b["pts_per_sec"];
+      const double p50 = r["p50_us"], b_p50 = b["p50_us"];
+      std::ostringstream message;
+      if (rate < (1.0 - tolerance) * b_rate) {
+        message << r["key"].get<std::string>() << ": " << rate
+                << " pts/s (baseline " << b_rate << ")";
+        regressions.push_back(message.str());
+      } else if (p50 > (1.0 + tolerance) * b_p50) {
+        message << r["key"].get<std::string>() << ": p50 " << p50
+                << " us (baseline " << b_p50 << ")";
+        regressions.push_back(message.str());
+      }
+    }
+    return regressions;
+  }
+
+} // namespace
+
+int main(int argc, char** argv) {
+  options opts;
+  try {
+    opts = parse_options(argc, argv);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << "\nUsage: tf2_bench --input <file>"
+              << " [--nb-pts <list>] [--batch-size <list>] [--dtype <list>]"
+              << " [--layout <list>] [--threads <list>] [--reps <n>]"
+              << " [--warmup <n>] [--output <file>] [--baseline <file>]"
+              << " [--tolerance <x>]" << std::endl;
+    return 1;
+  }
+  json report;
+  try {
+    std::ifstream file(opts.input);
+    const json base = json::parse(file);
+    report["version"] = tf2::version();
+    report["input"] = opts.input;
+    report["reps"] = opts.reps;
+    report["results"] = json::array();
+    // One model per layout, batch size and number of threads,
+    // evaluated on each precision and number of points
+    for (const auto &layout : opts.layout) {
+      for (const std::int32_t bs : opts.batch_size) {
+        for (const std::int32_t threads : opts.threads) {
+          const std::string inpfile = write_input(base, layout, bs, threads);
+          tf2::model mdl(inpfile);
+          std::filesystem::remove(inpfile);
+          for (const auto &dtype : opts.dtype) {
+            for (const std::int32_t nb_pts : opts.nb_pts) {
+              const setting s = {dtype, layout, bs, threads, nb_pts};
+              json result = (dtype == "float") ?
+                run<float>(mdl, s, opts) : run<double>(mdl, s, opts);
+              std::cerr << s.key() << ": "
+                        << result["pts_per_sec"].get<double>() << " pts/s, p50 "
+                        << result["p50_us"].get<double>() << " us, p99 "
+                        << result["p99_us"].get<double>() << " us" << std::endl;
+              report["results"].push_back(result);
+            }
+          }
+        }
+      }
+    }
+    // Column-major conversion in the graph against the host
+    report["transpose_in_graph"] = compare_layouts(report["results"]);
+    for (const auto &c : report["transpose_in_graph"]) {
+      std::cerr << c["key"].get<std::string>() << " vs col: speedup "
+                << c["speedup"].get<double>() << ", p50 ratio "
+                << c["p50_ratio"].get<double>() << std::endl;
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  // Report
+  if (opts.output.empty()) {
+    std::cout << report.dump(2) << std::endl;
+  } else {
+    std::ofstream(opts.output) << report.dump(2) << std::endl;
+  }
+  // Regressions against the baseline
+  if (!opts.baseline.empty()) {
+    std::vector<std::string> regressions;
+    try {
+      std::ifstream file(opts.baseline);
+      regressions = compare(report, json::parse(file), opts.tolerance);
+    } catch (const std::exception& e) {
+      std::cerr << "Invalid baseline '" << opts.baseline << "': "
+                << e.what() << std::endl;
+      return 1;
+    }
+    for (const auto &r : regressions) {
+      std::cerr << "Regression: " << r << std::endl;
+    }
+    if (!regressions.empty()) {
+      return 2;
+    }
+    std::cerr << "No regression against " << opts.baseline << std::endl;
+  }
+  return 0;
+}
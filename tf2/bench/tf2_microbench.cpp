@@ -0,0 +1,310 @@
+/**
+ * @brief tf2_microbench: microbenchmarks of the tf2 layout and CSV
+ *        helpers.
+ *
+ * Measures `tf2::ops::transpose`, `transpose_inplace`, `flatten`,
+ * `reshape` and `invert_major`, and `tf2::csv::read` and `write`, on
+ * double-precision arrays from cache-resident sizes to sizes larger
+ * than the last level cache. Each benchmark is repeated until it runs
+ * for at least the minimum time, and is reported as time per iteration
+ * and memory (or file) throughput, in the style of Google Benchmark.
+ *
+ * Usage: tf2_microbench [--filter <substring>] [--min-time <s>]
+ *          [--max-size <bytes>] [--format console|json]
+ *
+ * The defaults are: --min-time 0.2 and --max-size 134217728 (128 MiB
+ * per array; the CSV benchmarks stop at 16 MiB).
+ */
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <functional>
+#include <memory>
+#include <filesystem>
+#include <unistd.h>
+#include <nlohmann/json.hpp>
+#include "tf2.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+  // Harness
+  // ====================================
+  using clock = std::chrono::steady_clock;
+
+  // Keep a result alive, so that its computation is not optimized out
+  const void* volatile sink = nullptr;
+
+  template <typename T>
+  void escape(const T& value) {
+    sink = static_cast<const void*>(&value);
+  }
+
+  // A benchmark: `prepare` allocates its data (untimed) and returns
+  // the loop running `iterations` times its operation, which processes
+  // `bytes` bytes per iteration
+  using loop = std::function<void(std::size_t iterations)>;
+
+  struct benchmark {
+    std::string name;
+    std::size_t bytes;
+    std::function<loop()> prepare;
+  };
+
+  struct result {
+    std::string name;
+    std::size_t iterations;
+    double seconds;
+    std::size_t bytes;
+  };
+
+  result measure(const benchmark& b, const double min_time) {
+    const loop run = b.prepare();
+    std::size_t iterations = 1;
+    while (true) {
+      const auto t0 = clock::now();
+      run(iterations);
+      const std::chrono::duration<double> dt = clock::now() - t0;
+      if ((dt.count() >= min_time) || (iterations >= (1ull << 30))) {
+        return {b.name, iterations, dt.count(), b.bytes};
+      }
+      // Aim at 1.4 times the minimum time, growing at most 10 times
+      const double scale = (dt.count() > 0.0) ?
+        std::min(10.0, 1.4 * min_time / dt.count()) : 10.0;
+      iterations = std::max(
+        iterations + 1, static_cast<std::size_t>(iterations * scale)
+      );
+    }
+  }
+
+  // Data
+  // ====================================
+  std::vector<double> random_vector(const std::size_t n) {
+    std::mt19937 gen(1234);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    std::vector<double> v(n);
+    for (auto &x : v) {
+      x = dist(gen);
+    }
+    return v;
+  }
+
+  std::vector<std::vector<double>> random_matrix(
+    const std::size_t rows,
+    const std::size_t cols
+  ) {
+    const std::vector<double> v = random_vector(rows * cols);
+    std::vector<std::vector<double>> m(rows);
+    for (std::size_t i = 0; i < rows; ++i) {
+      m[i].assign(v.begin() + i * cols, v.begin() + (i + 1) * cols);
+    }
+    return m;
+  }
+
+  // Remove a file when the last copy of the handle is released
+  std::shared_ptr<void> remove_on_release(const std::string& path) {
+    return std::shared_ptr<void>(nullptr, [path](void*) {
+      std::filesystem::remove(path);
+    });
+  }
+
+  std::string size_name(const std::size_t bytes) {
+    return (bytes >= (1 << 20)) ?
+      std::to_string(bytes >> 20) + "MiB" :
+      std::to_string(bytes >> 10) + "KiB";
+  }
+
+  // Benchmarks
+  // ====================================
+  // Arrays of `bytes` bytes, as [nb_pts, 8] data (points of a
+  // small model) and as square matrices
+  void add_ops(std::vector<benchmark>& list, const std::size_t bytes) {
+    const std::size_t n = bytes / sizeof(double);
+    const std::int32_t cols = 8;
+    const std::int32_t rows = static_cast<std::int32_t>(n / cols);
+    const std::int32_t side = static_cast<std::int32_t>(std::sqrt(n));
+    const std::size_t square = static_cast<std::size_t>(side) * side;
+    const std::string size = "/" + size_name(bytes);
+    // Flat transposes (one read, one write)
+    list.push_back({"ops::transpose<tall>" + size, 2 * bytes, [=]() -> loop {
+      auto x = std::make_shared<std::vector<double>>(random_vector(n));
+      return [=](std::size_t it) {
+        for (std::size_t i = 0; i < it; ++i) {
+          escape(tf2::ops::transpose(*x, rows, cols));
+        }
+      };
+    }});
+    list.push_back({
+      "ops::transpose<square>" + size, 2 * sizeof(double) * square,
+      [=]() -> loop {
+        auto x = std::make_shared<std::vector<double>>(random_vector(square));
+        return [=](std::size_t it) {
+          for (std::size_t i = 0; i < it; ++i) {
+            escape(tf2::ops::transpose(*x, side, side));
+          }
+        };
+      }
+    });
+    list.push_back({
+      "ops::transpose_inplace" + size, 2 * sizeof(double) * square,
+      [=]() -> loop {
+        auto x = std::make_shared<std::vector<double>>(random_vector(square));
+        return [=](std::size_t it) {
+          for (std::size_t i = 0; i < it; ++i) {
+            tf2::ops::transpose_inplace(*x, side);
+            escape(*x);
+          }
+        };
+      }
+    });
+    list.push_back({"ops::transpose<2d>" + size, 2 * bytes, [=]() -> loop {
+      auto x = std::make_shared<std::vector<std::vector<double>>>(
+        random_matrix(rows, cols)
+      );
+      return [=](std::size_t it) {
+        for (std::size_t i = 0; i < it; ++i) {
+          escape(tf2::ops::transpose(*x));
+        }
+      };
+    }});
+    // Flattening and reshaping, in both major orderings
+    for (const bool col : {false, true}) {
+      const std::string order = col ? "<col>" : "<row>";
+      list.push_back({"ops::flatten" + order + size, 2 * bytes, [=]() -> loop {
+        auto x = std::make_shared<std::vector<std::vector<double>>>(
+          random_matrix(rows, cols)
+        );
+        return [=](std::size_t it) {
+          for (std::size_t i = 0; i < it; ++i) {
+            escape(tf2::ops::flatten(*x, col));
+          }
+        };
+      }});
+      list.push_back({"ops::reshape" + order + size, 2 * bytes, [=]() -> loop {
+        auto x = std::make_shared<std::vector<double>>(random_vector(n));
+        return [=](std::size_t it) {
+          for (std::size_t i = 0; i < it; ++i) {
+            escape(tf2::ops::reshape(*x, {rows, cols}, col));
+          }
+        };
+      }});
+    }
+    // Major ordering conversion of the points
+    list.push_back({"ops::invert_major" + size, 2 * bytes, [=]() -> loop {
+      auto x = std::make_shared<std::vector<double>>(random_vector(n));
+      return [=](std::size_t it) {
+        for (std::size_t i = 0; i < it; ++i) {
+          tf2::ops::invert_major(*x, rows, cols, false);
+          escape(*x);
+        }
+      };
+    }});
+  }
+
+  // CSV files of [nb_pts, 8] data of `bytes` bytes in binary
+  // (the throughput is that of the text file)
+  void add_csv(std::vector<benchmark>& list, const std::size_t bytes) {
+    const std::size_t rows = bytes / sizeof(double) / 8;
+    const std::string size = "/" + size_name(bytes);
+    const std::string path = (
+      std::filesystem::temp_directory_path() /
+      ("tf2_microbench_" + std::to_string(::getpid()) + ".csv")
+    ).string();
+    // Size of the file
+    tf2::csv::write(path, random_matrix(rows, 8));
+    const std::size_t file_size = std::filesystem::file_size(path);
+    std::filesystem::remove(path);
+    list.push_back({"csv::write" + size, file_size, [=]() -> loop {
+      auto x = std::make_shared<std::vector<std::vector<double>>>(
+        random_matrix(rows, 8)
+      );
+      auto file = remove_on_release(path);
+      return [=](std::size_t it) {
+        for (std::size_t i = 0; i < it; ++i) {
+          tf2::csv::write(path, *x);
+        }
+        escape(file);
+      };
+    }});
+    list.push_back({"csv::read" + size, file_size, [=]() -> loop {
+      tf2::csv::write(path, random_matrix(rows, 8));
+      auto file = remove_on_release(path);
+      return [=](std::size_t it) {
+        for (std::size_t i = 0; i < it; ++i) {
+          escape(tf2::csv::read<double>(path));
+        }
+        escape(file);
+      };
+    }});
+  }
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::string filter;
+  std::string format = "console";
+  double min_time = 0.2;
+  std::size_t max_size = 128 << 20;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if ((arg == "--filter") && (i + 1 < argc)) {
+      filter = argv[++i];
+    } else if ((arg == "--min-time") && (i + 1 < argc)) {
+      min_time = std::stod(argv[++i]);
+    } else if ((arg == "--max-size") && (i + 1 < argc)) {
+      max_size = std::stoull(argv[++i]);
+    } else if ((arg == "--format") && (i + 1 < argc)) {
+      format = argv[++i];
+    } else {
+      std::cerr << "Usage: tf2_microbench [--filter <substring>]"
+                << " [--min-time <s>] [--max-size <bytes>]"
+                << " [--format console|json]" << std::endl;
+      return 1;
+    }
+  }
+  // From L1-resident arrays to arrays larger than the LLC
+  std::vector<benchmark> list;
+  for (std::size_t bytes = 32 << 10; bytes <= max_size; bytes *= 8) {
+    add_ops(list, bytes);
+    if (bytes <= (16 << 20)) {
+      add_csv(list, bytes);
+    }
+  }
+  // Run
+  json report = {{"context", {{"version", tf2::version()}}}};
+  report["benchmarks"] = json::array();
+  if (format == "console") {
+    std::cout << std::left << std::setw(40) << "Benchmark"
+              << std::right << std::setw(16) << "Time"
+              << std::setw(14) << "Iterations"
+              << std::setw(14) << "GB/s" << "\n"
+              << std::string(84, '-') << std::endl;
+  }
+  for (const auto &b : list) {
+    if (b.name.find(filter) == std::string::npos) {
+      continue;
+    }
+    const result r = measure(b, min_time);
+    const double ns = 1.0e9 * r.seconds / r.iterations;
+    const double gbps = r.bytes * r.iterations / r.seconds * 1.0e-9;
+    if (format == "console") {
+      std::cout << std::left << std::setw(40) << r.name
+                << std::right << std::setw(13) << std::fixed
+                << std::setprecision(0) << ns << " ns"
+                << std::setw(14) << r.iterations
+                << std::setw(14) << std::setprecision(3) << gbps << std::endl;
+    }
+    report["benchmarks"].push_back({
+      {"name", r.name},
+      {"iterations", r.iterations},
+      {"real_time", ns},
+      {"time_unit", "ns"},
+      {"bytes_per_second", 1.0e9 * gbps}
+    });
+  }
+  if (format == "json") {
+    std::cout << report.dump(2) << std::endl;
+  }
+  return 0;
+}
@@ -12,12 +12,15 @@ if (CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
       set(LINKER_FLAGS "")
     elseif(CMAKE_BUILD_TYPE STREQUAL "Release")
       set(DEBUG_FLAGS "")
-      set(OPTIM_FLAG "-O3 -march=native -flto")
+      set(OPTIM_FLAG "-O3 -flto")
       set(LINKER_FLAGS "-flto")
+      if(TF2_NATIVE)
+        set(OPTIM_FLAG "${OPTIM_FLAG} -march=native")
+      endif()
     else()
       message(FATAL_ERROR "Unknown CMAKE_BUILD_TYPE: ${CMAKE_BUILD_TYPE}")
     endif()
-    set(CXX_FLAGS "${COMMON_CXX_FLAGS} ${OPTIM_CXX_FLAGS} ${DEBUG_CXX_FLAGS}")
+    set(CXX_FLAGS "${COMMON_FLAGS} ${OPTIM_FLAG} ${DEBUG_FLAGS}")
     set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} ${CXX_FLAGS}")
     set(CMAKE_EXE_LINKER_FLAGS "${CMAKE_EXE_LINKER_FLAGS}")
   endif()
@@ -16,7 +16,10 @@ if (CMAKE_Fortran_COMPILER_ID STREQUAL "GNU")
     elseif(CMAKE_BUILD_TYPE STREQUAL "Release")
       set(DEBUG_FLAG "")
       set(OPTIM_FLAG "-O3 -fPIC -fbounds-check -fbacktrace \
-        -march=native -funroll-loops -ftree-vectorize")
+        -funroll-loops -ftree-vectorize")
+      if(TF2_NATIVE)
+        set(OPTIM_FLAG "${OPTIM_FLAG} -march=native")
+      endif()
     else()
       message(FATAL_ERROR "Unknown CMAKE_BUILD_TYPE: ${CMAKE_BUILD_TYPE}")
     endif()
@@ -0,0 +1,69 @@
+/**
+ * @brief tf2d: node-local inference daemon.
+ *
+ * Hosts the models of the tf2 clients of a node (input files with
+ * "backend": "daemon"), so that they are loaded once and evaluated
+ * by a single TensorFlow runtime, merging the calls of the clients.
+ * Only the input files and models within the model directories (one
+ * or more `--model-dir`) can be opened.
+ *
+ * Usage: tf2d --model-dir <path> [--model-dir <path> ...] [--socket <path>]
+ *             [--max-batch-pts <n>] [--batch-window-us <n>]
+ */
+#include <csignal>
+#include "tf2.h"
+
+namespace {
+
+  tf2::server* instance = nullptr;
+
+  void on_signal(int) {
+    if (instance != nullptr) {
+      instance->stop();
+    }
+  }
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::vector<std::string> model_dirs;
+  std::string socket_path = tf2::ipc::default_socket;
+  std::int32_t max_batch_pts = 65536;
+  std::int32_t batch_window_us = 200;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if ((arg == "--model-dir") && (i + 1 < argc)) {
+      model_dirs.push_back(argv[++i]);
+    } else if ((arg == "--socket") && (i + 1 < argc)) {
+      socket_path = argv[++i];
+    } else if ((arg == "--max-batch-pts") && (i + 1 < argc)) {
+      max_batch_pts = std::stoi(argv[++i]);
+    } else if ((arg == "--batch-window-us") && (i + 1 < argc)) {
+      batch_window_us = std::stoi(argv[++i]);
+    } else {
+      model_dirs.clear();
+      break;
+    }
+  }
+  if (model_dirs.empty()) {
+    std::cerr << "Usage: tf2d --model-dir <path> [--model-dir <path> ...]"
+              << " [--socket <path>] [--max-batch-pts <n>]"
+              << " [--batch-window-us <n>]" << std::endl;
+    return 1;
+  }
+  try {
+    tf2::server server(
+      model_dirs, socket_path, max_batch_pts, batch_window_us
+    );
+    instance = &server;
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+    std::cout << "tf2d listening on " << socket_path << std::endl;
+    server.run();
+    instance = nullptr;
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,135 @@
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+#include <thread>
+#include <csignal>
+#include <filesystem>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <nlohmann/json.hpp>
+#include "tf2.h"
+
+#ifndef TF2D_PATH
+#define TF2D_PATH "tf2d"
+#endif
+
+
+// Evaluate the model through the tf2d daemon: start a daemon, open the
+// model with "backend": "daemon" and compare its outputs with the ones
+// of the in-process backend. The socket and the input file of the
+// daemon backend are created in a private temporary directory, which
+// is given to the daemon as a model directory, along with the one of
+// the model.
+int main(int argc, char** argv) {
+
+  std::cout << "Started!" << std::endl;
+
+  // Global inputs
+  std::string prefix = "/home/zanardi/Codes/ML/TF2/tf2/tf2/examples/msd/";
+  std::string tf2d = TF2D_PATH;
+  if (argc > 1) {
+    prefix = argv[1];
+  }
+  if (argc > 2) {
+    tf2d = argv[2];
+  }
+  int n = 100;
+  char tmpdir[] = "/tmp/tf2d-msd-XXXXXX";
+  if (::mkdtemp(tmpdir) == nullptr) {
+    std::cerr << "Error: cannot create a temporary directory." << std::endl;
+    return 1;
+  }
+  const std::string socket = std::string(tmpdir) + "/tf2d.sock";
+  const std::string inpfile = std::string(tmpdir) + "/inpfile.json";
+
+  // Input file of the daemon backend
+  nlohmann::json inputs;
+  std::ifstream(prefix + "cpp/inpfile.json") >> inputs;
+  inputs["backend"] = "daemon";
+  inputs["daemon_socket"] = socket;
+  std::ofstream(inpfile) << inputs.dump(2);
+  const std::string model_dir = std::filesystem::path(
+    inputs["path_to_model"].get<std::string>()
+  ).parent_path().string();
+
+  // Start the daemon
+  std::cout << "> Starting " << tf2d << " on " << socket << std::endl;
+  const pid_t daemon = ::fork();
+  if (daemon == 0) {
+    ::execl(
+      tf2d.c_str(), "tf2d",
+      "--model-dir", tmpdir,
+      "--model-dir", model_dir.c_str(),
+      "--socket", socket.c_str(),
+      (char*) nullptr
+    );
+    std::cerr << "Error: cannot run " << tf2d << std::endl;
+    ::_exit(1);
+  }
+  auto stop_daemon = [daemon]() {
+    ::kill(daemon, SIGTERM);
+    ::waitpid(daemon, nullptr, 0);
+  };
+  // Wait for the daemon to listen
+  bool listening = false;
+  for (int i = 0; (i < 100) && !listening; ++i) {
+    try {
+      ::close(tf2::ipc::connect(socket));
+      listening = true;
+    } catch (const std::exception&) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+  }
+  if (!listening) {
+    std::cerr << "Error: the daemon is not listening." << std::endl;
+    stop_daemon();
+    std::remove(inpfile.c_str());
+    ::rmdir(tmpdir);
+    return 1;
+  }
+
+  int status = 0;
+  try {
+    // Load the model in this process and on the daemon
+    std::cout << "> Loading models" << std::endl;
+    auto local = tf2::model(prefix + "cpp/inpfile.json");
+    auto remote = tf2::model(inpfile);
+
+    // Read input data
+    std::cout << "> Loading input data" << std::endl;
+    auto x = tf2::csv::read<float>(
+      prefix + "data.csv", {1, n+1}, {0, local.inp_tot_dim}
+    );
+    auto x_flt = tf2::ops::flatten(x);
+
+    // Perform inference with both backends
+    std::cout << "> Performing inference" << std::endl;
+    auto y_local = local.call(x_flt, n);
+    auto y_remote = remote.call(x_flt, n);
+
+    // Compare the outputs
+    float max_err = 0.0;
+    for (std::size_t i = 0; i < y_local.size(); ++i) {
+      max_err = std::max(max_err, std::abs(y_local[i] - y_remote[i]));
+    }
+    std::cout << "> Maximum difference: " << max_err << std::endl;
+    if ((y_local.size() != y_remote.size()) || (max_err > 1e-5)) {
+      std::cerr << "Error: the daemon outputs differ." << std::endl;
+      status = 1;
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    status = 1;
+  }
+
+  // Stop the daemon
+  stop_daemon();
+  std::remove(inpfile.c_str());
+  ::rmdir(tmpdir);
+
+  if (status == 0) {
+    std::cout << "Done!" << std::endl;
+  }
+
+  return status;
+}
@@ -0,0 +1,79 @@
+#include "tf2.h"
+
+
+// Check that the steady state of the inference is allocation-free:
+// once a first call has filled the model workspace, repeated calls
+// with the same number of points must not allocate any tensor buffer
+// or scratch array. Then check that the workspace stops growing with
+// a varying number of points: after a pass over odd numbers of points,
+// a second pass over the even numbers in between must not allocate.
+int main(int argc, char** argv) {
+
+  std::cout << "Started!" << std::endl;
+
+  // Global inputs
+  std::string prefix = "/home/zanardi/Codes/ML/TF2/tf2/tf2/examples/msd/";
+  if (argc > 1) {
+    prefix = argv[1];
+  }
+  int n = 100;
+  int nb_calls = 1000;
+
+  // Load model from file
+  std::cout << "> Loading model" << std::endl;
+  auto model = tf2::model(prefix + "cpp/inpfile.json");
+
+  // Inputs/outputs arrays (in double precision, so that the inputs are
+  // converted into pooled tensors rather than wrapped without copy)
+  std::vector<double> inputs(n * model.inp_tot_dim, 0.5);
+  std::vector<double> outputs(n * model.out_tot_dim);
+
+  // First call (fills the workspace)
+  std::cout << "> Performing first inference" << std::endl;
+  model.call(inputs.data(), outputs.data(), n);
+  const std::size_t nb_allocs = model.get_workspace().nb_allocs();
+
+  // Repeated calls
+  std::cout << "> Performing " << nb_calls << " inferences" << std::endl;
+  for (int i = 0; i < nb_calls; ++i) {
+    model.call(inputs.data(), outputs.data(), n);
+  }
+  const std::size_t new_allocs = model.get_workspace().nb_allocs() -
+    nb_allocs;
+  std::cout << "> Workspace allocations: " << new_allocs << std::endl;
+  if (new_allocs != 0) {
+    std::cerr << "Error: the repeated calls allocated memory." << std::endl;
+    return 1;
+  }
+
+  // Calls with a varying number of points (below 4n), first odd
+  // then even, in a scrambled order
+  std::cout << "> Performing " << 2 * nb_calls
+            << " inferences with varying number of points" << std::endl;
+  int max_n = 4 * n;
+  inputs.resize(max_n * model.inp_tot_dim, 0.5);
+  outputs.resize(max_n * model.out_tot_dim);
+  std::size_t pass_allocs[2];
+  for (int pass = 0; pass < 2; ++pass) {
+    const std::size_t allocs = model.get_workspace().nb_allocs();
+    for (int i = 0; i < nb_calls; ++i) {
+      int ni = (pass == 0) ? 2 * ((i * 7919) % (max_n / 2)) + 1
+                           : 2 * ((i * 7919) % (max_n / 2 - 1)) + 2;
+      model.call(inputs.data(), outputs.data(), ni);
+    }
+    pass_allocs[pass] = model.get_workspace().nb_allocs() - allocs;
+  }
+  std::cout << "> Workspace allocations (first pass): " << pass_allocs[0]
+            << std::endl;
+  std::cout << "> Workspace allocations (second pass): " << pass_allocs[1]
+            << std::endl;
+  if (pass_allocs[1] != 0) {
+    std::cerr << "Error: the workspace kept growing with a varying number "
+              << "of points." << std::endl;
+    return 1;
+  }
+
+  std::cout << "Done!" << std::endl;
+
+  return 0;
+}
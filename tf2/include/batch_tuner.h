@@ -0,0 +1,91 @@
+#ifndef tf2_batch_tuner_h_
+#define tf2_batch_tuner_h_
+
+#include "includes.h"
+
+namespace tf2 {
+
+  /**
+   * @brief Throughput-driven selection of the inference batch size.
+   *
+   * The tuner keeps the measured throughput (points per second) of a
+   * set of candidate batch sizes, smoothed over the recorded samples,
+   * and selects the fastest one. It is fed by a calibration sweep at
+   * model load and, optionally, by the timings of the model calls,
+   * periodically exploring the neighbours of the selected batch size
+   * so that the choice follows the actual workload.
+   */
+  class batch_tuner {
+
+  public:
+
+    /**
+     * @brief Measured throughput of a batch size.
+     */
+    struct point {
+      std::int32_t batch_size;
+      double pts_per_sec;
+      std::size_t nb_samples;
+    };
+
+    // Constructors
+    batch_tuner() = default;
+
+    /**
+     * @brief Candidate batch sizes (powers of two) of a sweep.
+     *
+     * @param max_size The largest batch size allowed.
+     * @return The candidate batch sizes, in increasing order.
+     */
+    static std::vector<std::int32_t> candidates(const std::int32_t max_size);
+
+    /**
+     * @brief Record the timing of an evaluation.
+     *
+     * @param batch_size The batch size used.
+     * @param nb_pts The number of evaluated points.
+     * @param seconds The elapsed time.
+     */
+    void record(
+      const std::int32_t batch_size,
+      const std::int32_t nb_pts,
+      const double seconds
+    );
+
+    /**
+     * @brief The batch size with the highest measured throughput
+     *        (-1 if nothing has been recorded).
+     */
+    std::int32_t best() const;
+
+    /**
+     * @brief The batch size to use for the next call.
+     *
+     * This is the best batch size, except once every `explore_period`
+     * calls, where one of its neighbours in the curve is returned
+     * instead, alternating between the smaller and the larger one.
+     */
+    std::int32_t next();
+
+    /**
+     * @brief The measured throughput of each batch size,
+     *        sorted by batch size.
+     */
+    const std::vector<point>& curve() const { return this->points; }
+
+    // Number of calls between two explorations
+    static constexpr std::size_t explore_period = 16;
+
+    // Weight of a new sample in the smoothed throughput
+    static constexpr double smoothing = 0.25;
+
+  private:
+
+    std::vector<point> points;
+    std::size_t nb_calls = 0;
+
+  };
+
+} // namespace tf2
+
+#endif // tf2_batch_tuner_h_
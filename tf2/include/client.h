@@ -0,0 +1,86 @@
+#ifndef tf2_client_h_
+#define tf2_client_h_
+
+#include "includes.h"
+#include "ipc.h"
+#include <memory>
+
+namespace tf2 {
+
+  /**
+   * @brief Connection to a model hosted by the `tf2d` daemon.
+   *
+   * The client opens the model from its input file on the daemon, which
+   * loads it once for all the processes of the node, and forwards the
+   * calls to it. The inputs are written to, and the outputs read from, a
+   * shared memory segment used as a ring of payloads, which grows with
+   * the largest call; only fixed-size headers go through the socket.
+   */
+  class client {
+
+  public:
+
+    /**
+     * @brief Connect to the daemon and open a model.
+     *
+     * @param socket_path The path of the daemon socket.
+     * @param inpfile The path of the model input file.
+     * @throws std::runtime_error If the daemon cannot be reached
+     *         or cannot open the model.
+     */
+    client(
+      const std::string& socket_path,
+      const std::string& inpfile
+    );
+
+    client(const client&) = delete;
+    client& operator=(const client&) = delete;
+
+    // Destructor
+    ~client();
+
+    // Inputs/Outputs dimensions of the hosted model
+    std::vector<std::int32_t> inputs_dim;
+    std::vector<std::int32_t> outputs_dim;
+
+    /**
+     * @brief Call the hosted model.
+     *
+     * The data layout is the one of the hosted model (see `rowmajor`).
+     *
+     * @tparam T The type of the input and output data.
+     * @param inputs Pointer to the input data.
+     * @param outputs Pointer to the output data.
+     * @param nb_pts The number of points.
+     * @throws std::runtime_error If the call fails on the daemon.
+     */
+    template <typename T>
+    void call(
+      const T* inputs,
+      T* outputs,
+      const std::int32_t nb_pts
+    );
+
+  private:
+
+    int fd = -1;
+    std::unique_ptr<tf2::ipc::shared_memory> shm;
+    std::size_t head = 0;
+    std::int32_t inp_tot_dim = 0;
+    std::int32_t out_tot_dim = 0;
+
+    // Send a request and wait for its reply (payload in `answer`)
+    void exchange(
+      tf2::ipc::request req,
+      const std::string& payload,
+      std::string& answer
+    );
+
+    // Get room for a payload in the ring, growing the segment if needed
+    std::size_t reserve(const std::size_t size);
+
+  };
+
+} // namespace tf2
+
+#endif // tf2_client_h_
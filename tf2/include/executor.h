@@ -0,0 +1,56 @@
+#ifndef tf2_executor_h_
+#define tf2_executor_h_
+
+#include "includes.h"
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <thread>
+#include <deque>
+#include <mutex>
+
+namespace tf2 {
+
+  /**
+   * @brief Background worker running tasks in submission order.
+   *
+   * The executor owns a single thread which runs the submitted tasks
+   * one at a time, in FIFO order. Each submission returns a future
+   * which becomes ready when the task completes, and which rethrows
+   * the exception thrown by the task, if any.
+   */
+  class executor {
+
+  public:
+
+    // Constructors
+    executor();
+    executor(const executor&) = delete;
+    executor& operator=(const executor&) = delete;
+
+    // Destructor (runs the pending tasks, then stops the thread)
+    ~executor();
+
+    /**
+     * @brief Submit a task.
+     *
+     * @param task The callable to run on the executor thread.
+     * @return A future which becomes ready when the task completes.
+     */
+    std::shared_future<void> submit(std::function<void()> task);
+
+  private:
+
+    std::thread worker;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::deque<std::packaged_task<void()>> tasks;
+    bool stop = false;
+
+    void loop();
+
+  };
+
+} // namespace tf2
+
+#endif // tf2_executor_h_
@@ -0,0 +1,56 @@
+#ifndef tf2_graph_h_
+#define tf2_graph_h_
+
+#include "includes.h"
+#include <tensorflow/c/c_api.h>
+
+namespace tf2 {
+
+  /**
+   * @brief Load-time rewrites of TensorFlow graphs.
+   */
+  namespace graph {
+
+    /**
+     * @brief Input/output identifiers of a rewritten graph.
+     */
+    struct endpoints {
+      std::vector<std::string> inputs_id;
+      std::vector<std::string> outputs_id;
+    };
+
+    /**
+     * @brief Move the column-major layout conversion into the graph.
+     *
+     * This function appends to the graph one placeholder per model
+     * input, fed with [dim, nb_pts] (column-major) data and followed
+     * by a `Transpose` node, and one `Transpose` node per model output,
+     * producing [dim, nb_pts] data. The operations depending on the
+     * original inputs are cloned under `prefix` and rewired to the
+     * transposed placeholders, since the operations of a graph already
+     * run by a session cannot be modified; the other operations (e.g.,
+     * variables) are shared with the original graph.
+     *
+     * @param graph The TensorFlow graph.
+     * @param inputs_id The model input identifiers ("<name>:<index>").
+     * @param outputs_id The model output identifiers ("<name>:<index>").
+     * @param inputs_dim The dimension of each model input.
+     * @param prefix The name scope of the appended operations (numbered
+     *               if already used, e.g., by another model sharing
+     *               the graph).
+     * @return The identifiers of the column-major inputs and outputs.
+     * @throws std::runtime_error If the graph cannot be rewritten.
+     */
+    endpoints transpose_io(
+      TF_Graph* graph,
+      const std::vector<std::string>& inputs_id,
+      const std::vector<std::string>& outputs_id,
+      const std::vector<std::int32_t>& inputs_dim,
+      const std::string& prefix = "tf2_colmajor"
+    );
+
+  } // namespace graph
+
+} // namespace tf2
+
+#endif // tf2_graph_h_
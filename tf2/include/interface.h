@@ -6,6 +6,29 @@
 
 namespace tf2 {
 
+  /**
+   * @brief Inference metrics of a TF2 model (see `tf2::metrics`).
+   *
+   * The per-phase arrays are indexed by `tf2::metrics::phase`
+   * (compose_inputs, session_run, compose_outputs, copies, call).
+   * The quantiles are the upper bounds of the histogram buckets
+   * holding them. The last counters are the input tensors wrapping
+   * the caller's memory, and the ones copied instead because it is
+   * not 64-byte aligned.
+   */
+  struct model_stats {
+    std::uint64_t nb_calls;
+    std::uint64_t nb_pts;
+    std::uint64_t bytes_in;
+    std::uint64_t bytes_out;
+    std::uint64_t count[tf2::metrics::nb_phases];
+    double seconds[tf2::metrics::nb_phases];
+    double p50[tf2::metrics::nb_phases];
+    double p99[tf2::metrics::nb_phases];
+    std::uint64_t zero_copy_inputs;
+    std::uint64_t unaligned_inputs;
+  };
+
   #ifdef __cplusplus
   extern "C" {
   #endif // __cplusplus
@@ -13,6 +36,10 @@ namespace tf2 {
     /**
      * @brief Initialize a TF2 model.
      *
+     * Models initialized from the same SavedModel, with the same session
+     * configuration, share a single graph and session (unless the input
+     * file sets `"share_session": false`).
+     *
      * @param inpfile Path to the input file.
      * @return A pointer to the initialized TF2 model.
      */
@@ -34,9 +61,20 @@ namespace tf2 {
      */
     std::int32_t get_out_tot_dim(tf2::model* mdl);
 
+    /**
+     * @brief Get the number of points per batch of the model
+     *        (e.g., as selected by `"batch_size": "auto"`).
+     *
+     * @param mdl Pointer to the TF2 model.
+     * @return Number of points per batch (-1 if not batched).
+     */
+    std::int32_t get_batch_size(tf2::model* mdl);
+
     /**
      * @brief Delete a TF2 model.
      *
+     * The graph and session are freed with the last model sharing them.
+     *
      * @param mdl Pointer to the TF2 model to delete.
      */
     void delete_model(tf2::model* mdl);
@@ -44,6 +82,11 @@ namespace tf2 {
     /**
      * @brief Call the TF2 model with single-precision inputs/outputs.
      *
+     * The inputs are read in place: row-major inputs are wrapped into
+     * the TensorFlow tensors without any copy (see the `zero_copy`
+     * option), while column-major inputs are reordered straight into
+     * the tensor memory. The outputs are written in place.
+     *
      * @param mdl Pointer to the TF2 model.
      * @param nb_pts Total number of evaluated points.
      * @param inputs 1D array of float inputs (row-/column-major).
@@ -59,6 +102,13 @@ namespace tf2 {
     /**
      * @brief Call the TF2 model with double-precision inputs/outputs.
      *
+     * The inputs are read in place: row-major inputs are wrapped into
+     * the TensorFlow tensors without any copy (see the `zero_copy`
+     * option), while column-major inputs are reordered straight into
+     * the tensor memory. The outputs are written in place.
+     * The model graph may be single-precision: the data is then
+     * converted to/from float32 within the same copy.
+     *
      * @param mdl Pointer to the TF2 model.
      * @param nb_pts Total number of evaluated points.
      * @param inputs 1D array of double inputs (row-/column-major).
@@ -71,6 +121,79 @@ namespace tf2 {
       double* outputs
     );
 
+    /**
+     * @brief Call the TF2 model asynchronously with single-precision
+     *        inputs/outputs.
+     *
+     * The call is queued and this function returns immediately. The
+     * inputs are read and the outputs written in place, as with
+     * `call_model_float`: both arrays must stay allocated, and the
+     * inputs unmodified, until `wait_model` returns.
+     *
+     * @param mdl Pointer to the TF2 model.
+     * @param nb_pts Total number of evaluated points.
+     * @param inputs 1D array of float inputs (row-/column-major).
+     * @param outputs Empty 1D array of float outputs.
+     */
+    void call_model_float_async(
+      tf2::model* mdl,
+      std::int32_t* nb_pts,
+      float* inputs,
+      float* outputs
+    );
+
+    /**
+     * @brief Call the TF2 model asynchronously with double-precision
+     *        inputs/outputs.
+     *
+     * Same as `call_model_float_async`, for double-precision arrays.
+     *
+     * @param mdl Pointer to the TF2 model.
+     * @param nb_pts Total number of evaluated points.
+     * @param inputs 1D array of double inputs (row-/column-major).
+     * @param outputs Empty 1D array of double outputs.
+     */
+    void call_model_double_async(
+      tf2::model* mdl,
+      std::int32_t* nb_pts,
+      double* inputs,
+      double* outputs
+    );
+
+    /**
+     * @brief Wait for the pending asynchronous calls of a TF2 model.
+     *
+     * @param mdl Pointer to the TF2 model.
+     * @throws std::exception The first error raised by the pending calls.
+     */
+    void wait_model(tf2::model* mdl);
+
+    /**
+     * @brief Wait for the warm-up runs of a TF2 model, when run
+     *        in background.
+     *
+     * @param mdl Pointer to the TF2 model.
+     * @throws std::exception The error raised by the warm-up, if any.
+     */
+    void wait_model_ready(tf2::model* mdl);
+
+    /**
+     * @brief Write the profiling tables of a TF2 model to a file.
+     *
+     * @param mdl Pointer to the TF2 model.
+     * @param filename Path to the output file.
+     * @throws std::runtime_error If the profiling is not enabled.
+     */
+    void dump_model_profile(tf2::model* mdl, const char* filename);
+
+    /**
+     * @brief Get the inference metrics of a TF2 model.
+     *
+     * @param mdl Pointer to the TF2 model.
+     * @param stats The metrics to fill.
+     */
+    void get_model_stats(tf2::model* mdl, tf2::model_stats* stats);
+
   #ifdef __cplusplus
   } // extern "C"
   #endif // __cplusplus
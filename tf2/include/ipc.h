@@ -0,0 +1,166 @@
+#ifndef tf2_ipc_h_
+#define tf2_ipc_h_
+
+#include "includes.h"
+
+namespace tf2 {
+
+  /**
+   * @brief Inter-process communication between the tf2 clients
+   *        and the `tf2d` daemon of a node.
+   *
+   * The clients talk to the daemon through a Unix domain socket, with
+   * fixed-size request/reply headers. The input/output payloads do not
+   * go through the socket: each client maps a POSIX shared memory
+   * segment, also mapped by the daemon, used as a ring of payloads.
+   */
+  namespace ipc {
+
+    // Default path of the daemon socket
+    inline const std::string default_socket = "/tmp/tf2d.sock";
+
+    // Alignment of the payloads in the shared memory
+    constexpr std::size_t alignment = 64;
+
+    inline std::size_t align(const std::size_t n) {
+      return (n + alignment - 1) / alignment * alignment;
+    }
+
+    // Request operations
+    enum op : std::uint32_t {
+      // Open a model: the payload is the path of its input file
+      open = 1,
+      // Map the shared memory segment: the payload is its name
+      map = 2,
+      // Call the model on the points stored at `offset`
+      call = 3
+    };
+
+    /**
+     * @brief Request header, followed by `length` bytes of payload.
+     */
+    struct request {
+      std::uint32_t op;
+      // Size of the data elements (call)
+      std::uint32_t dtype_size;
+      // Number of points (call)
+      std::int32_t nb_pts;
+      std::int32_t reserved;
+      // Offset of the inputs in the shared memory, followed by the
+      // outputs at the next aligned offset (call), or size of the
+      // segment (map)
+      std::uint64_t offset;
+      std::uint64_t length;
+    };
+
+    /**
+     * @brief Reply header, followed by `length` bytes of payload
+     *        (error message if `status` is not 0).
+     */
+    struct reply {
+      std::int32_t status;
+      std::uint32_t length;
+    };
+
+    // Sockets
+    /* ============================= */
+
+    /**
+     * @brief Send a whole buffer through a socket.
+     *
+     * @throws std::runtime_error If the connection is broken.
+     */
+    void send_all(
+      const int fd,
+      const void* data,
+      const std::size_t size
+    );
+
+    /**
+     * @brief Receive a whole buffer from a socket.
+     *
+     * @throws std::runtime_error If the connection is closed or broken.
+     */
+    void recv_all(
+      const int fd,
+      void* data,
+      const std::size_t size
+    );
+
+    /**
+     * @brief Connect to a Unix domain socket.
+     *
+     * @param path The path of the socket.
+     * @return The connected socket.
+     * @throws std::runtime_error If the connection fails.
+     */
+    int connect(const std::string& path);
+
+    /**
+     * @brief Listen on a Unix domain socket (replacing a stale one).
+     *
+     * The socket is only accessible to the user of the calling process
+     * (mode 0600).
+     *
+     * @param path The path of the socket.
+     * @return The listening socket.
+     * @throws std::runtime_error If another process is listening on
+     *         the socket, or if the socket cannot be bound.
+     */
+    int listen(const std::string& path);
+
+    // Shared memory
+    /* ============================= */
+
+    /**
+     * @brief Mapping of a POSIX shared memory segment.
+     */
+    class shared_memory {
+
+    public:
+
+      /**
+       * @brief Create or open a segment and map it.
+       *
+       * @param name The name of the segment ("/<name>").
+       * @param size The size of the segment in bytes.
+       * @param create Whether to create the segment (which must not exist).
+       * @throws std::runtime_error If the segment cannot be mapped.
+       */
+      shared_memory(
+        const std::string& name,
+        const std::size_t size,
+        const bool create
+      );
+
+      shared_memory(const shared_memory&) = delete;
+      shared_memory& operator=(const shared_memory&) = delete;
+
+      // Destructor (unmaps the segment, and removes it if still linked
+      // by its creator)
+      ~shared_memory();
+
+      /**
+       * @brief Remove the name of the segment, which is freed once
+       *        unmapped by all the processes.
+       */
+      void unlink();
+
+      void* data() const { return this->addr; }
+      std::size_t size() const { return this->len; }
+      const std::string& name() const { return this->id; }
+
+    private:
+
+      std::string id;
+      std::size_t len;
+      void* addr = nullptr;
+      bool linked = false;
+
+    };
+
+  } // namespace ipc
+
+} // namespace tf2
+
+#endif // tf2_ipc_h_
@@ -0,0 +1,184 @@
+#ifndef tf2_metrics_h_
+#define tf2_metrics_h_
+
+#include "includes.h"
+#include <condition_variable>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <array>
+#include <mutex>
+
+namespace tf2 {
+
+  /**
+   * @brief Always-on inference counters and latency histograms.
+   *
+   * All the updates are relaxed atomic increments, so that the calls
+   * (and the concurrent batches of a call) never wait on each other
+   * to record their metrics. The latencies are counted in histograms
+   * with power-of-two bounds, from 1 us to about 16 s.
+   */
+  class metrics {
+
+  public:
+
+    using clock = std::chrono::steady_clock;
+
+    // Timed phases
+    enum phase : std::size_t {
+      // Composition of the input tensors of a batch (copy/conversion
+      // of the caller's data, or wrapping)
+      compose_inputs = 0,
+      // Session run of a batch
+      session_run,
+      // Scattering of the output tensors of a batch
+      compose_outputs,
+      // Host copies outside the batches composition (e.g., gather and
+      // scatter of the points of the 2D calls evaluated by the daemon)
+      copies,
+      // Whole model call
+      call,
+      nb_phases
+    };
+
+    // Number of histogram buckets (the last one is unbounded)
+    static constexpr std::size_t nb_buckets = 26;
+
+    /**
+     * @brief Upper bound of a histogram bucket [s].
+     */
+    static double bucket_bound(const std::size_t k);
+
+    /**
+     * @brief The name of a phase.
+     */
+    static const char* phase_name(const std::size_t p);
+
+    /**
+     * @brief A consistent-enough copy of the metrics (each value
+     *        is read atomically, not the whole set).
+     */
+    struct snapshot {
+      std::uint64_t nb_calls = 0;
+      std::uint64_t nb_pts = 0;
+      std::uint64_t bytes_in = 0;
+      std::uint64_t bytes_out = 0;
+      std::uint64_t zero_copy_inputs = 0;
+      std::uint64_t unaligned_inputs = 0;
+      std::array<std::uint64_t, nb_phases> count{};
+      std::array<double, nb_phases> seconds{};
+      std::array<std::array<std::uint64_t, nb_buckets>, nb_phases> buckets{};
+
+      /**
+       * @brief Estimate a latency quantile of a phase, as the upper
+       *        bound of the bucket holding it [s] (0 if no sample).
+       *
+       * @param p The phase.
+       * @param q The quantile, in [0, 1].
+       */
+      double quantile(const std::size_t p, const double q) const;
+    };
+
+    // Constructors
+    metrics() = default;
+    metrics(const metrics&) = delete;
+    metrics& operator=(const metrics&) = delete;
+
+    // Destructor (stops the periodic dump)
+    ~metrics();
+
+    /**
+     * @brief Count a completed call.
+     *
+     * @param nb_pts The number of evaluated points.
+     * @param bytes_in The size of the caller's inputs.
+     * @param bytes_out The size of the caller's outputs.
+     */
+    void add_call(
+      const std::uint64_t nb_pts,
+      const std::uint64_t bytes_in,
+      const std::uint64_t bytes_out
+    );
+
+    /**
+     * @brief Count an input tensor eligible to wrap the caller's memory.
+     *
+     * @param wrapped Whether the memory was wrapped, or copied instead
+     *                because it is not aligned.
+     */
+    void add_zero_copy(const bool wrapped);
+
+    /**
+     * @brief Record the duration of a phase.
+     *
+     * @param p The phase.
+     * @param start The start time of the phase.
+     * @return The end time of the phase (i.e., now), to chain phases.
+     */
+    clock::time_point observe(const phase p, const clock::time_point start);
+
+    /**
+     * @brief Read the metrics.
+     */
+    snapshot read() const;
+
+    /**
+     * @brief Write the metrics in the Prometheus text exposition format.
+     *
+     * @param out The output stream.
+     * @param label The value of the `model` label of the samples.
+     */
+    void write_prometheus(std::ostream& out, const std::string& label) const;
+
+    /**
+     * @brief Write the metrics to a file periodically, from
+     *        a background thread.
+     *
+     * Each dump replaces the file atomically (written next to it,
+     * then renamed), so that it can be scraped at any time, e.g., by
+     * the textfile collector of the Prometheus node exporter.
+     *
+     * @param filename The path to the output file.
+     * @param period The time between two dumps [s].
+     * @param label The value of the `model` label of the samples.
+     * @throws std::invalid_argument If the period is not positive.
+     */
+    void start_dump(
+      const std::string& filename,
+      const double period,
+      const std::string& label
+    );
+
+    /**
+     * @brief Stop the periodic dump, after a last one.
+     */
+    void stop_dump();
+
+  private:
+
+    std::atomic<std::uint64_t> nb_calls{0};
+    std::atomic<std::uint64_t> nb_pts{0};
+    std::atomic<std::uint64_t> bytes_in{0};
+    std::atomic<std::uint64_t> bytes_out{0};
+    std::atomic<std::uint64_t> zero_copy_inputs{0};
+    std::atomic<std::uint64_t> unaligned_inputs{0};
+    std::array<std::atomic<std::uint64_t>, nb_phases> count{};
+    std::array<std::atomic<std::uint64_t>, nb_phases> nanoseconds{};
+    std::array<
+      std::array<std::atomic<std::uint64_t>, nb_buckets>, nb_phases
+    > buckets{};
+
+    // Periodic dump
+    std::thread dumper;
+    std::mutex dump_lock;
+    std::condition_variable dump_wake;
+    bool dump_stop = false;
+
+    void write_file(const std::string& filename, const std::string& label);
+
+  };
+
+} // namespace tf2
+
+#endif // tf2_metrics_h_
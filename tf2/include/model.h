@@ -3,10 +3,37 @@
 
 #include "includes.h"
 #include "utils.h"
+#include "signature.h"
+#include "graph.h"
+#include "workspace.h"
+#include "thread_pool.h"
+#include "executor.h"
+#include "batch_tuner.h"
+#include "profiler.h"
+#include "metrics.h"
+#include "registry.h"
+#include "client.h"
 #include <cppflow/cppflow.h>
+#include <atomic>
 
 namespace tf2 {
 
+  /**
+   * @brief Where a model is evaluated.
+   */
+  enum class backend {
+    // As set in the input file ("backend": "local" or "daemon")
+    inpfile,
+    // In this process
+    local,
+    // By the tf2d daemon of the node
+    daemon,
+    // In this process, on behalf of the clients of the tf2d daemon
+    // (the "env" block and the "metrics" file of the input file,
+    // chosen by the clients, are ignored)
+    hosted
+  };
+
   /**
    * @brief Class representing a TensorFlow-based TF2 model.
    */
@@ -14,32 +41,109 @@ namespace tf2 {
 
   private:
 
-    // TensorFlow model
+    // TensorFlow model (shared with the other tf2 models
+    // of the same SavedModel and session configuration)
     std::string path_to_model;
-    std::unique_ptr<cppflow::model> tfmodel;
-    std::vector<std::string>* config = nullptr;
+    std::shared_ptr<cppflow::model> tfmodel;
+    bool share_session = true;
+    // Format of the model ("model_format": "saved_model" or
+    // "frozen_graph", a GraphDef file mapped into memory)
+    cppflow::model::TYPE format = cppflow::model::TYPE::SAVED_MODEL;
 
-    // Inputs/Outputs
+    // Models hosted by the tf2d daemon (see `tf2::server`)
+    tf2::backend mode = tf2::backend::local;
+    std::string daemon_socket = tf2::ipc::default_socket;
+    std::unique_ptr<tf2::client> remote;
+    // Serialized ConfigProto of the eager context ("config")
+    // and of the model session
+    std::string config;
+    std::string session_config;
+    // Graph optimizations profile of the session, with its overrides
+    // (`"optimization"` block, e.g., "xla,remapping=off")
+    std::string optimization_profile = "default";
+
+    // Prepared input/output signatures and statuses
+    // (one per concurrent batch)
+    std::vector<tf2::signature> sigs;
+    std::vector<std::shared_ptr<TF_Status>> status;
+
+    // Persistent workspace (pooled tensors and scratch arrays)
+    std::unique_ptr<tf2::workspace> ws;
+
+    // Inputs/Outputs (the prefixes are only used to suggest
+    // identifiers when one is not found)
     const std::string inputs_id_prefix = "serving_default";
     const std::string outputs_id_prefix = "StatefulPartitionedCall";
-    const std::int32_t max_nb_io = 100;
 
     // Data major ordering
     bool rowmajor = true;
 
+    // Convert column-major inputs/outputs with `Transpose` nodes
+    // appended to the graph, instead of reordering them on the host
+    // (experimental: its benefit over the host conversion has not been
+    // measured with TensorFlow yet, see the `tf2_bench` comparison)
+    bool transpose_in_graph = false;
+
     // Batched inference
     std::int32_t batch_size = -1;
+    std::int32_t max_concurrent_batches = 1;
+    std::unique_ptr<tf2::thread_pool> pool;
+
+    // Pipelined batches: number of rotating buffer sets used to compose,
+    // run and scatter consecutive batches concurrently (1 disables it)
+    std::int32_t pipeline_depth = 1;
+    std::unique_ptr<tf2::thread_pool> pipe;
+
+    // Automatic batch size ("batch_size": "auto"), calibrated at load
+    // within the given limits (a non-positive memory cap means none),
+    // and optionally adapted at run time from the calls timings
+    bool auto_batch_size = false;
+    bool adaptive_batch_size = false;
+    std::int32_t max_batch_size = 65536;
+    double max_batch_memory_mb = 0.0;
+    tf2::batch_tuner tuner;
+
+    // Wrap the caller's memory into the input tensors when the
+    // data layout and its alignment allow it, instead of copying it
+    bool zero_copy = true;
+
+    // Serialize the calls sharing the model state (signatures,
+    // workspace and batches pool)
+    std::mutex call_lock;
+
+    // Sampled profiling of the session runs ("profiling" block)
+    std::unique_ptr<tf2::profiler> prof;
 
-    // IO operations
-    tf2::data::list_tuple_vector<int64_t> ops;
+    // Inference metrics, optionally dumped to a file periodically
+    // ("metrics" block)
+    tf2::metrics stats;
+    std::string metrics_file;
+    double metrics_period = 10.0;
+
+    // Duration of each construction phase [s]
+    std::vector<std::pair<std::string, double>> load_times;
+
+    // Warm-up runs on synthetic inputs, per number of points
+    // ("warmup" block), possibly run by the executor
+    std::int32_t warmup_runs = 0;
+    std::vector<std::int32_t> warmup_nb_pts;
+    bool warmup_background = false;
+    std::shared_future<void> warmup_done;
+    std::atomic<double> warmup_time{0.0};
+
+    // Asynchronous calls (the executor is started on first use)
+    std::mutex async_lock;
+    std::vector<std::shared_future<void>> pending;
+    std::unique_ptr<tf2::executor> exec;
 
     /**
      * @brief Check the availability of input/output operations
      *        and retrieve their dimensions.
      *
-     * This function checks the availability of input/output operations
-     * for the specified identifiers and retrieves their dimensions.
-     * If an identifier is not found, a std::runtime_error is thrown.
+     * This function resolves each identifier directly in the graph
+     * and retrieves the dimension of the identified output (e.g., of
+     * "StatefulPartitionedCall:1" for the second output). If an
+     * identifier is not found, a std::runtime_error is thrown.
      *
      * @param identifiers The list of identifiers to check.
      * @return A vector of integers representing the dimensions
@@ -52,16 +156,22 @@ namespace tf2 {
     );
 
     /**
-     * @brief Retrieve information about the
-     *        operations in the TensorFlow model.
+     * @brief Retrieve the datatypes of input/output operations.
+     *
+     * The caller's single- or double-precision data is converted
+     * on the fly from/to these datatypes, so that, e.g., double
+     * precision callers can run float32 graphs.
      *
-     * This function retrieves information about the operations
-     * in the TensorFlow model. It obtains the identifiers of all
-     * operations, filters them based on the specified input and
-     * output prefixes, and stores the identifier-shape pairs in
-     * the internal data structure.
+     * @param identifiers The input/output operation identifiers.
+     * @param endpoints The resolved input/output endpoints.
+     * @return The datatype of each operation.
+     * @throws std::runtime_error If a datatype is not supported
+     *         (float32, float64 and bfloat16 are).
      */
-    void get_ops_info();
+    std::vector<TF_DataType> check_io_dtypes(
+      const std::vector<std::string>& identifiers,
+      const std::vector<TF_Output>& endpoints
+    );
 
     /**
      * @brief Parse input information from a JSON file to construct the model.
@@ -70,8 +180,14 @@ namespace tf2 {
      * initializes the internal model parameters based on the parsed input data.
      *
      * @param inpfile The path to the JSON input file.
+     * @param hosted Whether the model is hosted by the tf2d daemon,
+     *               which ignores the environment variables and the
+     *               metrics file.
      */
-    void parse_inputs(const std::string inpfile);
+    void parse_inputs(
+      const std::string inpfile,
+      const bool hosted = false
+    );
 
     /**
      * @brief Set the global TensorFlow context with
@@ -81,78 +197,543 @@ namespace tf2 {
      * object with the provided configuration and replaces the
      * global TensorFlow context with the new options.
      *
-     * @param config The vector of strings representing the TensorFlow
-     *               configuration. Each string in the vector corresponds
-     *               to a configuration option.
+     * @param config The serialized ConfigProto.
+     */
+    void set_global_context(const std::string& config);
+
+    /**
+     * @brief Select the batch size with the highest throughput.
+     *
+     * This function evaluates the model on synthetic inputs for
+     * increasing batch sizes (powers of two, up to `max_batch_size`),
+     * until the throughput stops improving. When a memory cap is set,
+     * the batch sizes are limited so that the input/output tensors of
+     * all the batches in flight fit into it. The measured throughputs
+     * are kept in the batch size tuner.
+     *
+     * @throws std::invalid_argument If the memory cap does not allow
+     *         any batch size.
+     */
+    void calibrate_batch_size();
+
+    /**
+     * @brief Run the session on the tensor handles of a signature,
+     *        tracing the run when sampled by the profiler.
+     *
+     * @param sig The prepared signature.
+     * @param status The status used to report errors.
+     * @throws std::runtime_error If the session run fails.
+     */
+    void run_signature(tf2::signature& sig, TF_Status* status);
+
+    /**
+     * @brief Count a completed call in the metrics.
+     *
+     * @param nb_pts The number of evaluated points.
+     * @param value_size The size of the caller's values.
+     * @param start The start time of the call.
+     */
+    void count_call(
+      const std::int32_t nb_pts,
+      const std::size_t value_size,
+      const tf2::metrics::clock::time_point start
+    );
+
+    /**
+     * @brief Run the model on synthetic inputs.
+     *
+     * The first session runs pay for the graph optimizations, the
+     * kernel instantiations and the thread pools spin-up. This function
+     * runs the model `warmup_runs` times for each number of points of
+     * `warmup_nb_pts` (one batch by default), and records its duration.
      */
-    void set_global_context(const std::vector<std::string>& config);
+    void warmup();
+
+    /**
+     * @brief Allocate one signature and status per concurrent batch
+     *        and per pipeline buffer set.
+     */
+    void resize_slots();
 
     /**
      * @brief Compose input data for the TensorFlow model.
      *
      * This function composes input data for the TensorFlow model
-     * based on the provided inputs and the number of points.
-     * It processes each input, applies column-major ordering if
-     * necessary, converts the input to a TensorFlow tensor with
-     * the proper shape, and constructs a list of tuples containing
-     * the input identifiers and corresponding tensors.
+     * for the batch of points [start, start+size) of the provided
+     * inputs, and stores the resulting tensors in `tf_inputs`.
+     * The inputs are made of one block per model input, each one
+     * holding `nb_pts` points.
+     * Row-major inputs (and column-major inputs with a single point
+     * or feature) are wrapped without any copy when `zero_copy` is
+     * enabled and their first point is 64-byte aligned (TensorFlow
+     * copies the unaligned data itself; these inputs take the pooled
+     * copy instead, and are counted in the metrics).
+     * Otherwise, each input is written straight into a
+     * pooled tensor of the workspace; column-major inputs are gathered
+     * from their strided column slices (one copy).
+     * When `transpose_in_graph` is enabled (experimental), column-major
+     * inputs are fed as [dim, size] tensors and transposed by the graph:
+     * whole inputs are wrapped, and batches copied row by row, with no
+     * reordering on the host.
+     * Inputs whose graph datatype differs from T are never wrapped,
+     * and are converted within the same copy.
      *
      * @tparam T The type of the input data.
-     * @param inputs The vector of input data.
-     * @param nb_pts The number of points.
-     * @return A list of tuples representing the composed
-     *         input data in the specified format.
+     * @param inputs Pointer to the input data.
+     * @param nb_pts The total number of points.
+     * @param start The index of the first point of the batch.
+     * @param size The number of points of the batch.
+     * @param tf_inputs The composed TensorFlow input tensors.
+     *
+     * @note The caller owns the composed tensors, which must be
+     *       released with `TF_DeleteTensor` after inference.
      */
     template <typename T>
-    tf2::data::list_tuple_tensor compose_inputs(
-      const std::vector<T>& inputs,
-      const std::int32_t nb_pts
+    void compose_inputs(
+      const T* inputs,
+      const std::int32_t nb_pts,
+      const std::int32_t start,
+      const std::int32_t size,
+      TF_Tensor** tf_inputs
+    );
+
+    /**
+     * @brief Compose input data for the TensorFlow model from the
+     *        rows of point-major data.
+     *
+     * Same as above, but the data of the point `p` (all the inputs,
+     * concatenated) is read from `rows[p]`. Each input is gathered
+     * row by row straight into a pooled tensor of the workspace.
+     *
+     * @tparam T The type of the input data.
+     * @param rows Pointers to the rows of the input data.
+     * @param nb_pts The total number of points (unused).
+     * @param start The index of the first point of the batch.
+     * @param size The number of points of the batch.
+     * @param tf_inputs The composed TensorFlow input tensors.
+     */
+    template <typename T>
+    void compose_inputs(
+      const T* const* rows,
+      const std::int32_t nb_pts,
+      const std::int32_t start,
+      const std::int32_t size,
+      TF_Tensor** tf_inputs
     );
 
     /**
      * @brief Compose output data from TensorFlow model.
      *
      * This function composes output data from the TensorFlow
-     * model based on the TensorFlow output tensors and the
-     * number of points. It handles both single- and multi-output
-     * cases, adjusting for row-major and column-major ordering.
+     * model based on the TensorFlow output tensors of the batch
+     * of points [start, start+size). It handles both single- and
+     * multi-output cases, adjusting for row-major and column-major
+     * ordering. Each output tensor is read once, straight into its
+     * slice of the caller's array, with no intermediate copy, and
+     * converted to T if its graph datatype differs.
      *
      * @tparam T The type of the output data.
-     * @param outputs The vector to store the composed output data.
+     * @param outputs Pointer to the composed output data.
      * @param tf_outputs The TensorFlow output tensors.
-     * @param nb_pts The number of points.
+     * @param nb_pts The total number of points.
+     * @param start The index of the first point of the batch.
+     * @param size The number of points of the batch.
+     *
+     * @throws std::runtime_error If an output tensor datatype or
+     *         size does not match the caller's array.
      */
     template <typename T>
     void compose_outputs(
-      std::vector<T>& outputs,
-      const std::vector<cppflow::tensor>& tf_outputs,
+      T* outputs,
+      TF_Tensor* const* tf_outputs,
+      const std::int32_t nb_pts,
+      const std::int32_t start,
+      const std::int32_t size
+    );
+
+    /**
+     * @brief Compose output data from TensorFlow model into the
+     *        rows of point-major data.
+     *
+     * Same as above, but the outputs of the point `p` (all the
+     * outputs, concatenated) are written to `rows[p]`.
+     *
+     * @tparam T The type of the output data.
+     * @param rows Pointers to the rows of the output data.
+     * @param tf_outputs The TensorFlow output tensors.
+     * @param nb_pts The total number of points (unused).
+     * @param start The index of the first point of the batch.
+     * @param size The number of points of the batch.
+     *
+     * @throws std::runtime_error If an output tensor datatype or
+     *         size does not match the caller's array.
+     */
+    template <typename T>
+    void compose_outputs(
+      T* const* rows,
+      TF_Tensor* const* tf_outputs,
+      const std::int32_t nb_pts,
+      const std::int32_t start,
+      const std::int32_t size
+    );
+
+    /**
+     * @brief Check an output tensor against the graph datatype
+     *        and the batch shape.
+     *
+     * @param i The index of the output.
+     * @param tf_output The TensorFlow output tensor.
+     * @param size The number of points of the batch.
+     * @throws std::runtime_error If the tensor datatype or
+     *         size does not match.
+     */
+    void check_output(
+      const std::size_t i,
+      const TF_Tensor* tf_output,
+      const std::int32_t size
+    ) const;
+
+    /**
+     * @brief Evaluate the TensorFlow model on a batch of points.
+     *
+     * This function performs an evaluation of the TensorFlow model
+     * on the batch of points [start, start+size) of the provided
+     * data, using the signature and status of the given thread of
+     * the batches pool, so that several batches can run concurrently.
+     *
+     * @tparam T The type of the input and output data.
+     * @tparam X The type of the input data handle, either a pointer
+     *           to the input blocks (`const T*`) or to the rows of
+     *           point-major data (`const T* const*`).
+     * @tparam Y The type of the output data handle (`T*` or `T* const*`).
+     * @param inputs The input data.
+     * @param outputs The output data.
+     * @param nb_pts The total number of points.
+     * @param start The index of the first point of the batch.
+     * @param size The number of points of the batch.
+     * @param thread The index of the calling thread in the batches pool.
+     */
+    template <typename T, typename X, typename Y>
+    void evaluate(
+      X inputs,
+      Y outputs,
+      const std::int32_t nb_pts,
+      const std::int32_t start,
+      const std::int32_t size,
+      const std::size_t thread
+    );
+
+    /**
+     * @brief Evaluate the TensorFlow model on consecutive batches
+     *        through a three-stage pipeline.
+     *
+     * A producer thread composes the input tensors of batch i+1 and a
+     * consumer thread scatters the outputs of batch i-1 while batch i
+     * runs in TensorFlow on the calling thread, so that the host copies
+     * are hidden behind the inference. The batches rotate over
+     * `pipeline_depth` buffer sets (signatures and statuses): with
+     * three sets the stages fully overlap, with two the producer waits
+     * for the consumer to release the oldest set.
+     *
+     * @tparam T The type of the input and output data.
+     * @tparam X The type of the input data handle (see `evaluate`).
+     * @tparam Y The type of the output data handle (see `evaluate`).
+     * @param inputs The input data.
+     * @param outputs The output data.
+     * @param nb_pts The total number of points.
+     * @param size The number of points of a batch (but the last one).
+     * @param nb_batches The number of batches.
+     */
+    template <typename T, typename X, typename Y>
+    void run_pipelined(
+      X inputs,
+      Y outputs,
+      const std::int32_t nb_pts,
+      const std::int32_t size,
+      const std::int32_t nb_batches
+    );
+
+    /**
+     * @brief Evaluate the TensorFlow model on all the points,
+     *        split in batches of `batch_size` points if required.
+     *
+     * @tparam T The type of the input and output data.
+     * @tparam X The type of the input data handle (see `evaluate`).
+     * @tparam Y The type of the output data handle (see `evaluate`).
+     * @param inputs The input data.
+     * @param outputs The output data.
+     * @param nb_pts The number of points.
+     */
+    template <typename T, typename X, typename Y>
+    void run_batches(
+      X inputs,
+      Y outputs,
       const std::int32_t nb_pts
     );
 
   public:
 
-    // Constructor
-    explicit model(const std::string inpfile);
+    /**
+     * @brief Load a model from its input file.
+     *
+     * With the daemon backend, the model is opened on the tf2d daemon
+     * listening on `daemon_socket`, which runs the calls, possibly
+     * merged with the ones of the other processes of the node.
+     *
+     * @param inpfile The path of the input file.
+     * @param backend The backend, overriding the input file.
+     */
+    explicit model(
+      const std::string inpfile,
+      const tf2::backend backend = tf2::backend::inpfile
+    );
 
-    // Destructor
-    ~model() = default;
+    // Destructor (waits for the pending asynchronous calls)
+    ~model();
 
     // Inputs/Outputs
     std::vector<std::string> inputs_id;
     std::vector<std::string> outputs_id;
     std::vector<std::int32_t> inputs_dim;
     std::vector<std::int32_t> outputs_dim;
+    std::vector<TF_DataType> inputs_dtype;
+    std::vector<TF_DataType> outputs_dtype;
 
     // Inputs/Outputs total dimensions
     std::int32_t inp_tot_dim;
     std::int32_t out_tot_dim;
 
+    /**
+     * @brief Whether the inputs/outputs are row-major.
+     */
+    bool is_rowmajor() const { return this->rowmajor; }
+
+    /**
+     * @brief Get the persistent workspace of the model.
+     *
+     * The workspace counters (e.g., `nb_allocs()`) can be used to check
+     * that repeated calls with the same number of points do not allocate.
+     *
+     * @return A reference to the model workspace.
+     */
+    const tf2::workspace& get_workspace() const { return *this->ws; }
+
+    /**
+     * @brief Set the maximum number of batches run concurrently.
+     *
+     * When batched inference is enabled, the batches of a single call
+     * are dispatched to a pool of threads and run concurrently on the
+     * same TensorFlow session, each one writing its own slice of the
+     * outputs. A value of 1 runs the batches one after another.
+     *
+     * @param n The maximum number of concurrent batches.
+     * @throws std::invalid_argument If n is lower than 1.
+     */
+    void set_max_concurrent_batches(const std::int32_t n);
+
+    /**
+     * @brief Get the maximum number of batches run concurrently.
+     */
+    std::int32_t get_max_concurrent_batches() const {
+      return this->max_concurrent_batches;
+    }
+
+    /**
+     * @brief Set the number of points per batch.
+     *
+     * This also stops the run time adaptation of the batch size.
+     *
+     * @param n The number of points per batch (batched inference
+     *          is disabled if lower than 1).
+     */
+    void set_batch_size(const std::int32_t n);
+
+    /**
+     * @brief Get the number of points per batch (either set or
+     *        selected by the calibration).
+     */
+    std::int32_t get_batch_size() const {
+      return this->batch_size;
+    }
+
+    /**
+     * @brief Get the measured throughput of each batch size.
+     *
+     * The curve is filled by the calibration of `"batch_size": "auto"`
+     * and, with run time adaptation, updated by the model calls.
+     *
+     * @return A copy of the curve, sorted by batch size.
+     */
+    std::vector<tf2::batch_tuner::point> get_batch_size_curve();
+
+    /**
+     * @brief Get the duration of each construction phase.
+     *
+     * The phases are, in order: "parse_inputs", "context" (global
+     * TensorFlow context), "load" (graph and session, or registry
+     * lookup), "check_io" (input/output dimensions), "signatures"
+     * (endpoints and graph rewrites), "workspace" (workspace, batches
+     * pool and pipeline), "calibration" (with `"batch_size": "auto"`)
+     * and "warmup" (with a `"warmup"` block, unless run in background).
+     * Models evaluated by the tf2d daemon report "parse_inputs" and
+     * "connect" only.
+     *
+     * @return The name and duration [s] of each phase.
+     */
+    const std::vector<std::pair<std::string, double>>&
+    get_load_times() const {
+      return this->load_times;
+    }
+
+    /**
+     * @brief Get the graph optimizations profile of the session.
+     *
+     * The `"optimization"` block of the input file selects a profile
+     * ("default", TensorFlow's own settings; "none", no graph
+     * optimization; "grappler", constant folding, arithmetic and layout
+     * optimizers and remapper fusions, e.g., of dense layers and their
+     * activations; "xla", the same with XLA JIT compilation of the whole
+     * graph, on CPU too), whose passes can be switched on or off one by
+     * one ("constant_folding", "arithmetic_optimization",
+     * "layout_optimizer", "remapping" and "xla_jit" booleans).
+     *
+     * @return The profile name, followed by its overrides
+     *         (e.g., "xla,remapping=off").
+     */
+    const std::string& get_optimization_profile() const {
+      return this->optimization_profile;
+    }
+
+    /**
+     * @brief Read the inference metrics.
+     *
+     * The metrics count the calls, points and bytes of the caller's
+     * inputs/outputs, the input tensors wrapping the caller's memory
+     * (and the ones copied because it is not aligned), and the latency
+     * of each phase: the composition of the input tensors, the session
+     * runs and the scattering of the output tensors of each batch, the
+     * host copies outside the batches (2D calls evaluated by the daemon)
+     * and the whole calls. The warm-up runs are included.
+     *
+     * @return A copy of the metrics.
+     */
+    tf2::metrics::snapshot get_stats() const {
+      return this->stats.read();
+    }
+
+    /**
+     * @brief Write the inference metrics in the Prometheus text
+     *        exposition format (labeled with the model path).
+     *
+     * The `"metrics"` block of the input file (`"file"` and
+     * `"period_s"`, 10 by default) writes them to a file periodically.
+     *
+     * @param out The output stream.
+     */
+    void write_metrics(std::ostream& out) const {
+      this->stats.write_prometheus(out, this->path_to_model);
+    }
+
+    /**
+     * @brief Enable or disable the sampled profiling.
+     *
+     * Once every `period` session runs (each batch is a run), the run
+     * is traced and its step statistics are aggregated into per-node
+     * and per-operation-type kernel time tables. This can also be set
+     * with the `"profiling"` block of the input file (`"period"`, 100 by
+     * default, and `"trace_level"`: "software", "hardware" or "full").
+     * Enabling the profiling discards the previous tables.
+     *
+     * @param period The number of session runs between two traced
+     *               ones (the profiling is disabled if lower than 1).
+     */
+    void set_profiling(const std::int32_t period);
+
+    /**
+     * @brief Write the profiling tables.
+     *
+     * @param out The output stream.
+     * @throws std::runtime_error If the profiling is not enabled.
+     */
+    void dump_profile(std::ostream& out);
+
+    /**
+     * @brief Write the profiling tables to a file.
+     *
+     * @param filename The path to the output file.
+     * @throws std::runtime_error If the profiling is not enabled,
+     *         or if the file cannot be opened.
+     */
+    void dump_profile(const std::string& filename);
+
+    /**
+     * @brief Forget the profiling tables collected so far.
+     */
+    void reset_profile();
+
+    /**
+     * @brief Wait for the warm-up runs to complete.
+     *
+     * With `"background": true` in the `"warmup"` block, the warm-up
+     * runs are queued on the executor of the asynchronous calls at the
+     * end of the construction. The model can be called meanwhile (the
+     * calls wait for the warm-up run in progress). This function
+     * returns immediately otherwise.
+     *
+     * @throws std::exception The error raised by the warm-up, if any.
+     */
+    void wait_ready();
+
+    /**
+     * @brief Get the duration of the warm-up runs [s] (0 if not run,
+     *        or not completed yet).
+     */
+    double get_warmup_time() const {
+      return this->warmup_time;
+    }
+
+    /**
+     * @brief Set the depth of the batches pipeline.
+     *
+     * When batched inference is enabled and the batches run one after
+     * another (see `set_max_concurrent_batches`), a depth of 2 or 3
+     * overlaps the composition of the next batch and the scattering
+     * of the previous one with the inference of the current batch,
+     * using as many rotating buffer sets. A value of 1 disables it.
+     *
+     * @param n The number of rotating buffer sets.
+     * @throws std::invalid_argument If n is lower than 1.
+     */
+    void set_pipeline_depth(const std::int32_t n);
+
+    /**
+     * @brief Get the depth of the batches pipeline.
+     */
+    std::int32_t get_pipeline_depth() const {
+      return this->pipeline_depth;
+    }
+
     /**
      * @brief Evaluate the TensorFlow model.
      *
      * This function performs an evaluation of the TensorFlow
      * model based on the provided input data, updating the
-     * specified output vector for the given number of points.
+     * specified output array for the given number of points.
+     *
+     * @tparam T The type of the input and output data.
+     * @param inputs Pointer to the input data.
+     * @param outputs Pointer to the output data.
+     * @param nb_pts The number of points.
+     */
+    template <typename T>
+    void evaluate(
+      const T* inputs,
+      T* outputs,
+      const std::int32_t nb_pts
+    );
+
+    /**
+     * @brief Evaluate the TensorFlow model.
      *
      * @tparam T The type of the input and output data.
      * @param inputs The vector of input data.
@@ -166,6 +747,27 @@ namespace tf2 {
       const std::int32_t nb_pts
     );
 
+    /**
+     * @brief Perform model inference on input data, handling
+     *        batched inference if applicable.
+     *
+     * This function performs inference on the provided input data,
+     * reading the inputs and updating the outputs in place on the
+     * caller's arrays. If batched inference is enabled, it processes
+     * the input data in batches, for both row- and column-major data.
+     *
+     * @tparam T The type of the input and output data.
+     * @param inputs Pointer to the input data.
+     * @param outputs Pointer to the output data.
+     * @param nb_pts The number of points in the input data.
+     */
+    template <typename T>
+    void call(
+      const T* inputs,
+      T* outputs,
+      const std::int32_t nb_pts
+    );
+
     /**
      * @brief Perform model inference on input data, handling
      *        batched inference if applicable.
@@ -178,10 +780,6 @@ namespace tf2 {
      * @param inputs The vector of input data.
      * @param outputs The vector to store the output data.
      * @param nb_pts The number of points in the input data.
-     *
-     * @throws std::runtime_error If column-major ordered
-     *         input data are provided for batched inference
-     *         (which is not currently supported).
      */
     template <typename T>
     void call(
@@ -214,14 +812,21 @@ namespace tf2 {
      *        and return the outputs.
      *
      * This function performs a model inference for the given vector
-     * of input sequences. It first forces the internal data major
-     * ordering to be column-major, then flattens the input sequences,
-     * performs the inference using the flattened inputs, and finally
-     * reshapes the output to match the specified shape.
+     * of points, each one holding all the inputs concatenated, and
+     * returns one vector of concatenated outputs per point. The rows
+     * are gathered straight into the input tensors, and the outputs
+     * scattered straight into the returned rows, without going through
+     * a flattened copy. The major ordering of the model is unchanged.
+     *
+     * @note This function used to switch the model to column-major data
+     *       for good, so that the subsequent calls on flat arrays read
+     *       and wrote them column-major. It no longer does: the outputs
+     *       of this function are the same, but the code relying on that
+     *       switch must set `"rowmajor": false` in the input file.
      *
      * @tparam T The type of the input and output data.
-     * @param inputs The vector of input sequences.
-     * @param nb_pts The number of points in each input sequence.
+     * @param inputs The vector of points (inputs of each point concatenated).
+     * @param nb_pts The number of points.
      * @return A 2D vector representing the batched outputs.
      */
     template <typename T>
@@ -230,6 +835,38 @@ namespace tf2 {
       const std::int32_t nb_pts
     );
 
+    /**
+     * @brief Perform model inference asynchronously.
+     *
+     * This function queues the inference on the internal executor of
+     * the model and returns immediately. The calls run one at a time,
+     * in submission order, and never overlap with synchronous calls.
+     * The inputs are read and the outputs written in place, as with
+     * `call`: both arrays must stay alive, and the inputs unmodified,
+     * until the returned future is ready (or `wait` returns).
+     *
+     * @tparam T The type of the input and output data.
+     * @param inputs Pointer to the input data.
+     * @param outputs Pointer to the output data.
+     * @param nb_pts The number of points in the input data.
+     * @return A future which becomes ready when the outputs are written,
+     *         and which rethrows the inference error, if any.
+     */
+    template <typename T>
+    std::shared_future<void> call_async(
+      const T* inputs,
+      T* outputs,
+      const std::int32_t nb_pts
+    );
+
+    /**
+     * @brief Wait for all the pending asynchronous calls.
+     *
+     * @throws std::exception The first error raised by the pending
+     *         calls, if any.
+     */
+    void wait();
+
   };
 
 } // namespace tf2
@@ -0,0 +1,122 @@
+#ifndef tf2_profiler_h_
+#define tf2_profiler_h_
+
+#include "includes.h"
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <tensorflow/c/c_api.h>
+
+namespace tf2 {
+
+  /**
+   * @brief Sampled per-operation profiling of the session runs.
+   *
+   * Once every `period` session runs, the run is traced through the
+   * `RunOptions` trace level, and the step statistics returned in its
+   * `RunMetadata` are aggregated per graph node and per operation type.
+   * The other runs are not traced, so that the profiling can be left
+   * on in production at a small cost.
+   */
+  class profiler {
+
+  public:
+
+    /**
+     * @brief Aggregated timings of a graph node or operation type.
+     */
+    struct entry {
+      std::string name;
+      std::string type;
+      std::size_t count = 0;
+      // Kernel compute time [us]
+      double op_us = 0.0;
+      // Time from scheduling to the end of the outputs [us]
+      double all_us = 0.0;
+    };
+
+    // Trace levels of `RunOptions`
+    enum level : std::int32_t {
+      software = 1,
+      hardware = 2,
+      full = 3
+    };
+
+    /**
+     * @brief Constructor.
+     *
+     * @param period The number of session runs between two traced ones.
+     * @param trace_level The trace level of the traced runs.
+     * @throws std::invalid_argument If the period is lower than 1.
+     */
+    profiler(
+      const std::int32_t period,
+      const level trace_level = software
+    );
+
+    /**
+     * @brief Whether the next session run is to be traced.
+     */
+    bool sample();
+
+    /**
+     * @brief The serialized `RunOptions` of the traced runs.
+     */
+    const TF_Buffer* run_options() const { return this->options.get(); }
+
+    /**
+     * @brief Aggregate the step statistics of a traced run.
+     *
+     * @param graph The graph of the session, used to find the type
+     *              of the nodes.
+     * @param metadata The serialized `RunMetadata` of the run.
+     */
+    void record(TF_Graph* graph, const TF_Buffer* metadata);
+
+    /**
+     * @brief The aggregated timings per graph node, by decreasing
+     *        kernel time.
+     */
+    std::vector<entry> nodes() const;
+
+    /**
+     * @brief The aggregated timings per operation type, by decreasing
+     *        kernel time (the names are empty).
+     */
+    std::vector<entry> types() const;
+
+    /**
+     * @brief The number of traced session runs.
+     */
+    std::size_t nb_traced() const;
+
+    /**
+     * @brief Write the per-type and per-node tables.
+     *
+     * The times are averaged over the traced runs.
+     *
+     * @param out The output stream.
+     */
+    void dump(std::ostream& out) const;
+
+    /**
+     * @brief Forget the aggregated timings.
+     */
+    void reset();
+
+  private:
+
+    std::int32_t period;
+    std::atomic<std::uint64_t> nb_runs{0};
+    std::unique_ptr<TF_Buffer, decltype(&TF_DeleteBuffer)> options;
+
+    mutable std::mutex lock;
+    std::size_t traced = 0;
+    std::map<std::string, entry> table;
+
+  };
+
+} // namespace tf2
+
+#endif // tf2_profiler_h_
@@ -0,0 +1,52 @@
+#ifndef tf2_registry_h_
+#define tf2_registry_h_
+
+#include "includes.h"
+#include <memory>
+#include <cppflow/cppflow.h>
+
+namespace tf2 {
+
+  /**
+   * @brief Process-wide registry of the loaded TensorFlow models.
+   *
+   * Loading a SavedModel (or a frozen graph) builds a graph and a
+   * session holding all the weights. The registry shares them among
+   * the tf2 models created from the same file with the same format
+   * and session configuration: each
+   * tf2 model is then a lightweight handle, with its own input/output
+   * settings and workspace, over one reference-counted graph and
+   * session, which are freed when the last handle is deleted.
+   */
+  namespace registry {
+
+    /**
+     * @brief Get the loaded model of a SavedModel or frozen graph,
+     *        loading it if needed.
+     *
+     * Different models are loaded concurrently, while the callers
+     * requesting a model being loaded wait for it.
+     *
+     * @param path_to_model The path to the SavedModel directory or
+     *                      to the frozen graph file.
+     * @param config The serialized ConfigProto of the session.
+     * @param type The model format.
+     * @return A shared reference to the loaded model.
+     * @throws std::runtime_error If the model cannot be loaded.
+     */
+    std::shared_ptr<cppflow::model> acquire(
+      const std::string& path_to_model,
+      const std::string& config,
+      const cppflow::model::TYPE type = cppflow::model::TYPE::SAVED_MODEL
+    );
+
+    /**
+     * @brief Number of models currently loaded through the registry.
+     */
+    std::size_t nb_models();
+
+  } // namespace registry
+
+} // namespace tf2
+
+#endif // tf2_registry_h_
@@ -0,0 +1,153 @@
+#ifndef tf2_server_h_
+#define tf2_server_h_
+
+#include "includes.h"
+#include "model.h"
+#include "ipc.h"
+#include <condition_variable>
+#include <filesystem>
+#include <exception>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <deque>
+#include <map>
+
+namespace tf2 {
+
+  /**
+   * @brief Inference server of the `tf2d` daemon.
+   *
+   * The server hosts the models opened by the clients of a node, each
+   * one loaded once, from its input file, however many processes use
+   * it, and runs their calls with a single TensorFlow runtime (and
+   * intra-op thread pool). The calls of the clients of a model are
+   * queued and merged into batches of up to `max_batch_pts` points:
+   * when several clients share the model, the server waits up to
+   * `batch_window_us` microseconds for them to join a batch.
+   * The models stay loaded until the server stops. The `"env"` block
+   * and the `"metrics"` file of the input files sent by the clients
+   * are ignored: the server does not change its environment or write
+   * to the paths chosen by the clients. It only reads the input files,
+   * and the models they point to, found within the model directories
+   * it was given.
+   */
+  class server {
+
+  public:
+
+    /**
+     * @brief Listen on a Unix domain socket.
+     *
+     * @param model_dirs The directories of the input files and models
+     *                   which can be opened by the clients.
+     * @param socket_path The path of the socket.
+     * @param max_batch_pts The maximum number of points of a merged batch.
+     * @param batch_window_us The time to wait for the other clients
+     *                        of a model before running a batch.
+     * @throws std::invalid_argument If no model directory is given.
+     * @throws std::runtime_error If the socket cannot be bound.
+     */
+    explicit server(
+      const std::vector<std::string>& model_dirs,
+      const std::string& socket_path = tf2::ipc::default_socket,
+      const std::int32_t max_batch_pts = 65536,
+      const std::int32_t batch_window_us = 200
+    );
+
+    server(const server&) = delete;
+    server& operator=(const server&) = delete;
+
+    // Destructor (disconnects the clients and unloads the models)
+    ~server();
+
+    /**
+     * @brief Accept and serve the clients until `stop` is called.
+     */
+    void run();
+
+    /**
+     * @brief Stop accepting clients (async-signal-safe).
+     */
+    void stop();
+
+  private:
+
+    // Call of a client, run within a batch
+    struct job {
+      std::uint32_t dtype_size;
+      const void* inputs;
+      void* outputs;
+      std::int32_t nb_pts;
+      bool done = false;
+      std::exception_ptr error;
+    };
+
+    // Hosted model, with its queue of calls and batching thread
+    struct hosted {
+      std::unique_ptr<tf2::model> mdl;
+      std::mutex lock;
+      // Loading state (the model is loaded by its first client, while
+      // the other ones wait for it on `ready`)
+      bool loaded = false;
+      std::exception_ptr load_error;
+      std::condition_variable ready;
+      std::condition_variable wake;
+      std::condition_variable done;
+      std::deque<job*> queue;
+      std::size_t nb_clients = 0;
+      bool stop = false;
+      // Merged batches buffers
+      std::vector<char> inputs;
+      std::vector<char> outputs;
+      std::thread dispatcher;
+    };
+
+    std::string socket_path;
+    std::int32_t max_batch_pts;
+    std::int32_t batch_window_us;
+    int listen_fd = -1;
+    std::atomic<bool> stopping{false};
+
+    // Directories of the input files and models (resolved)
+    std::vector<std::filesystem::path> model_dirs;
+
+    // Hosted models (keyed by input file) and connected clients
+    std::mutex lock;
+    std::condition_variable idle;
+    std::map<std::string, std::shared_ptr<hosted>> models;
+    std::vector<int> clients;
+    std::size_t nb_sessions = 0;
+
+    // Open a model for a client, loading it if needed (outside of
+    // the server lock, so that the other clients are not blocked)
+    hosted& open(const std::string& inpfile);
+
+    // Check that a path lies within the model directories
+    void check_path(const std::string& path) const;
+
+    // Serve the requests of a client
+    void serve(const int fd);
+
+    // Run a call of a client through the queue of its model
+    void call(
+      hosted& h,
+      const tf2::ipc::shared_memory& shm,
+      const tf2::ipc::request& req
+    );
+
+    // Merge the queued calls of a model into batches
+    void dispatch(hosted& h);
+
+    // Run a batch of calls with the same datatype
+    template <typename T>
+    void run_jobs(
+      hosted& h,
+      const std::vector<job*>& jobs
+    );
+
+  };
+
+} // namespace tf2
+
+#endif // tf2_server_h_
@@ -0,0 +1,98 @@
+#ifndef tf2_signature_h_
+#define tf2_signature_h_
+
+#include "includes.h"
+#include <tensorflow/c/c_api.h>
+
+namespace tf2 {
+
+  /**
+   * @brief Prepared input/output signature of a TensorFlow graph.
+   *
+   * A signature resolves the input/output operation identifiers
+   * (e.g., "serving_default_input_1:0") to graph endpoints once, at
+   * construction, and keeps them together with reusable arrays of
+   * tensor handles. Running a session through a signature goes
+   * straight to `TF_SessionRun`, with no string parsing, no graph
+   * lookups and no allocations on the calling side.
+   */
+  class signature {
+
+  public:
+
+    // Constructors
+    signature() = default;
+
+    /**
+     * @brief Resolve the input/output endpoints of a graph.
+     *
+     * @param graph The TensorFlow graph.
+     * @param inputs_id The input operation identifiers ("<name>:<index>").
+     * @param outputs_id The output operation identifiers ("<name>:<index>").
+     * @throws std::runtime_error If an identifier is not found in the graph.
+     */
+    signature(
+      TF_Graph* graph,
+      const std::vector<std::string>& inputs_id,
+      const std::vector<std::string>& outputs_id
+    );
+
+    // Resolved graph endpoints
+    std::vector<TF_Output> inputs;
+    std::vector<TF_Output> outputs;
+
+    // Reusable input/output tensor handles
+    std::vector<TF_Tensor*> inp_val;
+    std::vector<TF_Tensor*> out_val;
+
+    /**
+     * @brief Resolve a single operation identifier to a graph endpoint.
+     *
+     * @param graph The TensorFlow graph.
+     * @param id The operation identifier ("<name>:<index>" or "<name>").
+     * @return The resolved graph endpoint.
+     * @throws std::runtime_error If the operation is not found in the graph.
+     */
+    static TF_Output resolve(TF_Graph* graph, const std::string& id);
+
+    /**
+     * @brief Run the session on the given input/output tensor handles.
+     *
+     * The input handles are borrowed. On success, the output handles
+     * are owned by the caller and must be released with `TF_DeleteTensor`.
+     *
+     * @param session The TensorFlow session.
+     * @param inp_val The input tensors (one per input endpoint).
+     * @param out_val The output tensors (one per output endpoint).
+     * @param status The status used to report errors.
+     * @param run_options The serialized `RunOptions` (e.g., trace level),
+     *                    if any.
+     * @param run_metadata The buffer receiving the serialized
+     *                     `RunMetadata` (e.g., step statistics), if any.
+     * @throws std::runtime_error If the session run fails.
+     */
+    void run(
+      TF_Session* session,
+      TF_Tensor* const* inp_val,
+      TF_Tensor** out_val,
+      TF_Status* status,
+      const TF_Buffer* run_options = nullptr,
+      TF_Buffer* run_metadata = nullptr
+    ) const;
+
+    /**
+     * @brief Run the session on the signature's own tensor handles.
+     *
+     * @param session The TensorFlow session.
+     * @param status The status used to report errors.
+     */
+    void run(
+      TF_Session* session,
+      TF_Status* status
+    );
+
+  };
+
+} // namespace tf2
+
+#endif // tf2_signature_h_
@@ -4,7 +4,19 @@
 // TF2 headers
 #include "includes.h"
 #include "utils.h"
+#include "signature.h"
+#include "graph.h"
+#include "workspace.h"
+#include "thread_pool.h"
+#include "executor.h"
+#include "batch_tuner.h"
+#include "profiler.h"
+#include "metrics.h"
+#include "registry.h"
+#include "ipc.h"
+#include "client.h"
 #include "model.h"
+#include "server.h"
 #include "interface.h"
 
 namespace tf2 {
@@ -0,0 +1,106 @@
+#ifndef tf2_thread_pool_h_
+#define tf2_thread_pool_h_
+
+#include "includes.h"
+#include <condition_variable>
+#include <exception>
+#include <type_traits>
+#include <thread>
+#include <atomic>
+#include <mutex>
+
+namespace tf2 {
+
+  /**
+   * @brief Fixed-size pool of worker threads for data-parallel loops.
+   *
+   * The pool runs the iterations of a loop concurrently on its worker
+   * threads and on the calling thread. Each iteration is given the
+   * index of the thread running it (0 for the calling thread), which
+   * can be used to address per-thread state. Dispatching a loop does
+   * not allocate any memory.
+   */
+  class thread_pool {
+
+  public:
+
+    /**
+     * @brief Start the worker threads.
+     *
+     * @param nb_threads The total number of threads running a loop,
+     *                   including the calling thread.
+     */
+    explicit thread_pool(const std::size_t nb_threads);
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    // Destructor
+    ~thread_pool();
+
+    /**
+     * @brief Total number of threads running a loop,
+     *        including the calling thread.
+     */
+    std::size_t size() const { return this->workers.size() + 1; }
+
+    /**
+     * @brief Run a loop concurrently and wait for its completion.
+     *
+     * This function calls `task(i, t)` for each `i` in `[0, n)`, where
+     * `t` is the index of the thread running the iteration. If some
+     * iterations throw, the first exception is rethrown to the caller
+     * once all the iterations are completed.
+     *
+     * @note Loops must not be dispatched concurrently on the same pool.
+     *
+     * @tparam F The type of the task.
+     * @param n The number of iterations.
+     * @param task The callable run for each iteration.
+     */
+    template <typename F>
+    void parallel_for(
+      const std::size_t n,
+      F&& task
+    ) {
+      using task_t = typename std::remove_reference<F>::type;
+      this->run(
+        n,
+        [](void* ctx, std::size_t i, std::size_t t) {
+          (*static_cast<task_t*>(ctx))(i, t);
+        },
+        static_cast<void*>(&task)
+      );
+    }
+
+  private:
+
+    using task_fn = void (*)(void*, std::size_t, std::size_t);
+
+    // Worker threads
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable done;
+    bool stop = false;
+
+    // Current loop
+    task_fn fn = nullptr;
+    void* ctx = nullptr;
+    std::size_t nb_iters = 0;
+    std::size_t generation = 0;
+    std::size_t nb_busy = 0;
+    std::atomic<std::size_t> next{0};
+    std::exception_ptr error;
+
+    void run(const std::size_t n, task_fn fn, void* ctx);
+
+    void work(const std::size_t t);
+
+    void loop(const std::size_t t);
+
+  };
+
+} // namespace tf2
+
+#endif // tf2_thread_pool_h_
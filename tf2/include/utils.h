@@ -4,5 +4,6 @@
 #include "utils/data.h"
 #include "utils/csv.h"
 #include "utils/ops.h"
+#include "utils/proto.h"
 
 #endif // tf2_utils_h_
@@ -104,8 +104,8 @@ namespace tf2 {
       const int precision = 6
     ) {
       std::ofstream file(filename);
-      for (auto i = 0; i < vec.size(); i++) {
-        for (auto j = 0; j < vec[i].size(); j++) {
+      for (std::size_t i = 0; i < vec.size(); i++) {
+        for (std::size_t j = 0; j < vec[i].size(); j++) {
           file << std::setprecision(precision) << vec[i][j];
           if (j != vec[i].size()-1) {
             file << ",";
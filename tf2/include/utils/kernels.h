@@ -0,0 +1,634 @@
+#ifndef tf2_utils_kernels_h_
+#define tf2_utils_kernels_h_
+
+#include "../includes.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace tf2 {
+
+  /**
+   * @brief Low-level data layout kernels.
+   *
+   * The kernels work on raw pointers and are the building blocks of the
+   * layout helpers in tf2::ops. Transpositions are cache-blocked, use
+   * SIMD micro-kernels for single- and double-precision data (AVX on
+   * x86 when enabled, e.g., with `-DTF2_NATIVE=ON`, NEON on ARM, scalar
+   * code elsewhere), and are split across
+   * threads for arrays larger than `parallel_threshold` elements.
+   */
+  namespace kernels {
+
+    // Threading
+    /* ============================= */
+
+    /**
+     * @brief Maximum number of threads used by a single kernel call.
+     */
+    inline std::size_t max_threads = std::max(
+      1u, std::thread::hardware_concurrency()
+    );
+
+    /**
+     * @brief Minimum number of elements handled by each thread.
+     *
+     * Arrays smaller than this threshold are processed by the calling
+     * thread only. The inference path of tf2::model never spawns
+     * threads: its kernels run on the calling thread, and the batches
+     * of a call run concurrently on the model thread pool instead.
+     */
+    inline std::size_t parallel_threshold = std::size_t(1) << 20;
+
+    /**
+     * @brief Split a range of rows across threads.
+     *
+     * @tparam F The type of the task, called as `task(begin, end)`.
+     * @param n The number of rows.
+     * @param work The total number of elements to process.
+     * @param task The callable processing a sub-range of rows.
+     * @param max_nb_threads The maximum number of threads (1 runs the
+     *                       task on the calling thread only).
+     */
+    template <typename F>
+    void parallel_rows(
+      const std::size_t n,
+      const std::size_t work,
+      F&& task,
+      const std::size_t max_nb_threads = max_threads
+    ) {
+      const std::size_t nb_threads = std::min(
+        {max_nb_threads, work / std::max<std::size_t>(parallel_threshold, 1), n}
+      );
+      if (nb_threads < 2) {
+        task(std::size_t(0), n);
+        return;
+      }
+      const std::size_t chunk = (n + nb_threads - 1) / nb_threads;
+      std::vector<std::thread> threads;
+      threads.reserve(nb_threads - 1);
+      for (std::size_t t = 1; t < nb_threads; ++t) {
+        const std::size_t begin = std::min(n, t * chunk);
+        const std::size_t end = std::min(n, begin + chunk);
+        threads.emplace_back([&task, begin, end]() { task(begin, end); });
+      }
+      task(std::size_t(0), std::min(n, chunk));
+      for (auto &thread : threads) {
+        thread.join();
+      }
+    }
+
+    // Micro-kernels
+    /* ============================= */
+
+    /**
+     * @brief Transpose of a square register tile.
+     *
+     * The generic version has no SIMD tile (size 0), and the tiled
+     * loops fall back to scalar code, left to the compiler to vectorize.
+     *
+     * @tparam T The type of the array elements.
+     */
+    template <typename T>
+    struct micro {
+      static constexpr std::size_t size = 0;
+      static void transpose(const T*, std::size_t, T*, std::size_t) {}
+    };
+
+#if defined(__AVX__)
+
+    template <>
+    struct micro<float> {
+      static constexpr std::size_t size = 8;
+      static void transpose(
+        const float* a,
+        const std::size_t lda,
+        float* t,
+        const std::size_t ldt
+      ) {
+        __m256 r0 = _mm256_loadu_ps(a);
+        __m256 r1 = _mm256_loadu_ps(a + lda);
+        __m256 r2 = _mm256_loadu_ps(a + 2*lda);
+        __m256 r3 = _mm256_loadu_ps(a + 3*lda);
+        __m256 r4 = _mm256_loadu_ps(a + 4*lda);
+        __m256 r5 = _mm256_loadu_ps(a + 5*lda);
+        __m256 r6 = _mm256_loadu_ps(a + 6*lda);
+        __m256 r7 = _mm256_loadu_ps(a + 7*lda);
+        // Interleave pairs of rows
+        const __m256 u0 = _mm256_unpacklo_ps(r0, r1);
+        const __m256 u1 = _mm256_unpackhi_ps(r0, r1);
+        const __m256 u2 = _mm256_unpacklo_ps(r2, r3);
+        const __m256 u3 = _mm256_unpackhi_ps(r2, r3);
+        const __m256 u4 = _mm256_unpacklo_ps(r4, r5);
+        const __m256 u5 = _mm256_unpackhi_ps(r4, r5);
+        const __m256 u6 = _mm256_unpacklo_ps(r6, r7);
+        const __m256 u7 = _mm256_unpackhi_ps(r6, r7);
+        // Gather 4-element columns within each 128-bit lane
+        const __m256 s0 = _mm256_shuffle_ps(u0, u2, _MM_SHUFFLE(1,0,1,0));
+        const __m256 s1 = _mm256_shuffle_ps(u0, u2, _MM_SHUFFLE(3,2,3,2));
+        const __m256 s2 = _mm256_shuffle_ps(u1, u3, _MM_SHUFFLE(1,0,1,0));
+        const __m256 s3 = _mm256_shuffle_ps(u1, u3, _MM_SHUFFLE(3,2,3,2));
+        const __m256 s4 = _mm256_shuffle_ps(u4, u6, _MM_SHUFFLE(1,0,1,0));
+        const __m256 s5 = _mm256_shuffle_ps(u4, u6, _MM_SHUFFLE(3,2,3,2));
+        const __m256 s6 = _mm256_shuffle_ps(u5, u7, _MM_SHUFFLE(1,0,1,0));
+        const __m256 s7 = _mm256_shuffle_ps(u5, u7, _MM_SHUFFLE(3,2,3,2));
+        // Swap 128-bit lanes
+        r0 = _mm256_permute2f128_ps(s0, s4, 0x20);
+        r1 = _mm256_permute2f128_ps(s1, s5, 0x20);
+        r2 = _mm256_permute2f128_ps(s2, s6, 0x20);
+        r3 = _mm256_permute2f128_ps(s3, s7, 0x20);
+        r4 = _mm256_permute2f128_ps(s0, s4, 0x31);
+        r5 = _mm256_permute2f128_ps(s1, s5, 0x31);
+        r6 = _mm256_permute2f128_ps(s2, s6, 0x31);
+        r7 = _mm256_permute2f128_ps(s3, s7, 0x31);
+        _mm256_storeu_ps(t, r0);
+        _mm256_storeu_ps(t + ldt, r1);
+        _mm256_storeu_ps(t + 2*ldt, r2);
+        _mm256_storeu_ps(t + 3*ldt, r3);
+        _mm256_storeu_ps(t + 4*ldt, r4);
+        _mm256_storeu_ps(t + 5*ldt, r5);
+        _mm256_storeu_ps(t + 6*ldt, r6);
+        _mm256_storeu_ps(t + 7*ldt, r7);
+      }
+    };
+
+    template <>
+    struct micro<double> {
+      static constexpr std::size_t size = 4;
+      static void transpose(
+        const double* a,
+        const std::size_t lda,
+        double* t,
+        const std::size_t ldt
+      ) {
+        const __m256d r0 = _mm256_loadu_pd(a);
+        const __m256d r1 = _mm256_loadu_pd(a + lda);
+        const __m256d r2 = _mm256_loadu_pd(a + 2*lda);
+        const __m256d r3 = _mm256_loadu_pd(a + 3*lda);
+        // Interleave pairs of rows
+        const __m256d u0 = _mm256_unpacklo_pd(r0, r1);
+        const __m256d u1 = _mm256_unpackhi_pd(r0, r1);
+        const __m256d u2 = _mm256_unpacklo_pd(r2, r3);
+        const __m256d u3 = _mm256_unpackhi_pd(r2, r3);
+        // Swap 128-bit lanes
+        _mm256_storeu_pd(t, _mm256_permute2f128_pd(u0, u2, 0x20));
+        _mm256_storeu_pd(t + ldt, _mm256_permute2f128_pd(u1, u3, 0x20));
+        _mm256_storeu_pd(t + 2*ldt, _mm256_permute2f128_pd(u0, u2, 0x31));
+        _mm256_storeu_pd(t + 3*ldt, _mm256_permute2f128_pd(u1, u3, 0x31));
+      }
+    };
+
+#elif defined(__ARM_NEON)
+
+    template <>
+    struct micro<float> {
+      static constexpr std::size_t size = 4;
+      static void transpose(
+        const float* a,
+        const std::size_t lda,
+        float* t,
+        const std::size_t ldt
+      ) {
+        const float32x4x2_t p01 = vtrnq_f32(vld1q_f32(a), vld1q_f32(a + lda));
+        const float32x4x2_t p23 = vtrnq_f32(
+          vld1q_f32(a + 2*lda), vld1q_f32(a + 3*lda)
+        );
+        vst1q_f32(t, vcombine_f32(
+          vget_low_f32(p01.val[0]), vget_low_f32(p23.val[0])
+        ));
+        vst1q_f32(t + ldt, vcombine_f32(
+          vget_low_f32(p01.val[1]), vget_low_f32(p23.val[1])
+        ));
+        vst1q_f32(t + 2*ldt, vcombine_f32(
+          vget_high_f32(p01.val[0]), vget_high_f32(p23.val[0])
+        ));
+        vst1q_f32(t + 3*ldt, vcombine_f32(
+          vget_high_f32(p01.val[1]), vget_high_f32(p23.val[1])
+        ));
+      }
+    };
+
+#if defined(__aarch64__)
+    template <>
+    struct micro<double> {
+      static constexpr std::size_t size = 2;
+      static void transpose(
+        const double* a,
+        const std::size_t lda,
+        double* t,
+        const std::size_t ldt
+      ) {
+        const float64x2_t r0 = vld1q_f64(a);
+        const float64x2_t r1 = vld1q_f64(a + lda);
+        vst1q_f64(t, vzip1q_f64(r0, r1));
+        vst1q_f64(t + ldt, vzip2q_f64(r0, r1));
+      }
+    };
+#endif // __aarch64__
+
+#endif // __AVX__ / __ARM_NEON
+
+    // Conversion
+    /* ============================= */
+
+    /**
+     * @brief Brain floating-point format (bfloat16) storage type.
+     *
+     * The value is stored as the upper 16 bits of the single-precision
+     * representation, rounded to nearest even.
+     */
+    struct bfloat16 {
+      std::uint16_t bits;
+
+      bfloat16() = default;
+
+      explicit bfloat16(const float value) {
+        std::uint32_t u;
+        std::memcpy(&u, &value, sizeof(u));
+        if ((u & 0x7FFFFFFFu) > 0x7F800000u) {
+          // Quiet NaN
+          this->bits = static_cast<std::uint16_t>((u >> 16) | 0x0040u);
+        } else {
+          u += 0x7FFFu + ((u >> 16) & 1u);
+          this->bits = static_cast<std::uint16_t>(u >> 16);
+        }
+      }
+
+      explicit bfloat16(const double value)
+        : bfloat16(static_cast<float>(value)) {}
+
+      explicit operator float() const {
+        const std::uint32_t u = static_cast<std::uint32_t>(this->bits) << 16;
+        float value;
+        std::memcpy(&value, &u, sizeof(value));
+        return value;
+      }
+
+      explicit operator double() const {
+        return static_cast<float>(*this);
+      }
+    };
+
+    /**
+     * @brief Copy an array, converting its elements.
+     *
+     * The conversion loop is left to the compiler to vectorize
+     * (e.g., packed double/single-precision conversions).
+     *
+     * @tparam T The type of the input array elements.
+     * @tparam U The type of the output array elements.
+     * @param a Pointer to the input array.
+     * @param t Pointer to the output array.
+     * @param n The number of elements.
+     */
+    template <typename T, typename U = T>
+    void convert(
+      const T* a,
+      U* t,
+      const std::size_t n
+    ) {
+      if constexpr (std::is_same<T, U>::value) {
+        std::copy(a, a + n, t);
+      } else {
+        for (std::size_t k = 0; k < n; ++k) {
+          t[k] = static_cast<U>(a[k]);
+        }
+      }
+    }
+
+    /**
+     * @brief Copy the rows of a strided 2D array, converting its elements.
+     *
+     * @tparam T The type of the input array elements.
+     * @tparam U The type of the output array elements.
+     * @param a Pointer to the input array.
+     * @param t Pointer to the output array.
+     * @param dim1 The number of rows.
+     * @param dim2 The number of columns.
+     * @param lda The row stride of the input array.
+     * @param ldt The row stride of the output array.
+     */
+    template <typename T, typename U = T>
+    void copy_rows(
+      const T* a,
+      U* t,
+      const std::size_t dim1,
+      const std::size_t dim2,
+      const std::size_t lda,
+      const std::size_t ldt
+    ) {
+      for (std::size_t i = 0; i < dim1; ++i) {
+        convert<T, U>(a + i*lda, t + i*ldt, dim2);
+      }
+    }
+
+    // Transpose
+    /* ============================= */
+
+    /**
+     * @brief Edge length of the cache blocks (about 256 bytes per row,
+     *        i.e., 16 KiB for a source/destination pair of blocks).
+     */
+    template <typename T>
+    constexpr std::size_t tile() {
+      return std::max<std::size_t>(8, 256 / sizeof(T));
+    }
+
+    /**
+     * @brief Transpose a block of a strided 2D array (single thread).
+     *
+     * @tparam T The type of the input array elements.
+     * @tparam U The type of the output array elements (converted
+     *           from T; the SIMD tiles are used when U is T).
+     * @param a Pointer to the input array.
+     * @param t Pointer to the output array.
+     * @param i0 First row of the block.
+     * @param i1 Past-the-end row of the block.
+     * @param j0 First column of the block.
+     * @param j1 Past-the-end column of the block.
+     * @param lda The row stride of the input array.
+     * @param ldt The row stride of the output array.
+     */
+    template <typename T, typename U = T>
+    void transpose_block(
+      const T* a,
+      U* t,
+      const std::size_t i0,
+      const std::size_t i1,
+      const std::size_t j0,
+      const std::size_t j1,
+      const std::size_t lda,
+      const std::size_t ldt
+    ) {
+      std::size_t i = i0;
+      if constexpr (std::is_same<T, U>::value && micro<T>::size > 0) {
+        constexpr std::size_t m = micro<T>::size;
+        for (; i + m <= i1; i += m) {
+          std::size_t j = j0;
+          for (; j + m <= j1; j += m) {
+            micro<T>::transpose(a + i*lda + j, lda, t + j*ldt + i, ldt);
+          }
+          for (std::size_t ii = i; ii < i + m; ++ii) {
+            for (std::size_t jj = j; jj < j1; ++jj) {
+              t[jj*ldt + ii] = a[ii*lda + jj];
+            }
+          }
+        }
+      }
+      for (; i < i1; ++i) {
+        for (std::size_t j = j0; j < j1; ++j) {
+          t[j*ldt + i] = static_cast<U>(a[i*lda + j]);
+        }
+      }
+    }
+
+    /**
+     * @brief Transpose a strided 2D array (cache-blocked, SIMD, threaded).
+     *
+     * The input is a dim1 x dim2 row-major array with row stride `lda`,
+     * and the output the dim2 x dim1 row-major array with row stride `ldt`.
+     *
+     * @tparam T The type of the input array elements.
+     * @tparam U The type of the output array elements (converted from T).
+     * @param a Pointer to the input array.
+     * @param t Pointer to the output array (must not overlap the input).
+     * @param dim1 The number of rows of the input array.
+     * @param dim2 The number of columns of the input array.
+     * @param lda The row stride of the input array.
+     * @param ldt The row stride of the output array.
+     * @param max_nb_threads The maximum number of threads (1 runs the
+     *                       transpose on the calling thread only).
+     */
+    template <typename T, typename U = T>
+    void transpose(
+      const T* a,
+      U* t,
+      const std::size_t dim1,
+      const std::size_t dim2,
+      const std::size_t lda,
+      const std::size_t ldt,
+      const std::size_t max_nb_threads = max_threads
+    ) {
+      // Vectors are plain copies
+      if (dim1 == 1 || dim2 == 1) {
+        const std::size_t n = std::max(dim1, dim2);
+        const std::size_t sa = (dim1 == 1) ? 1 : lda;
+        const std::size_t st = (dim2 == 1) ? 1 : ldt;
+        for (std::size_t k = 0; k < n; ++k) {
+          t[k*st] = static_cast<U>(a[k*sa]);
+        }
+        return;
+      }
+      // Split the blocks of rows across threads
+      constexpr std::size_t b = tile<T>();
+      const std::size_t nb_blocks = (dim1 + b - 1) / b;
+      parallel_rows(nb_blocks, dim1 * dim2,
+        [&](std::size_t begin, std::size_t end) {
+          for (std::size_t bi = begin; bi < end; ++bi) {
+            const std::size_t i0 = bi * b;
+            const std::size_t i1 = std::min(dim1, i0 + b);
+            for (std::size_t j0 = 0; j0 < dim2; j0 += b) {
+              const std::size_t j1 = std::min(dim2, j0 + b);
+              transpose_block<T, U>(a, t, i0, i1, j0, j1, lda, ldt);
+            }
+          }
+        },
+        max_nb_threads
+      );
+    }
+
+    /**
+     * @brief Transpose a square row-major array in place.
+     *
+     * @tparam T The type of the array elements.
+     * @param a Pointer to the array.
+     * @param n The number of rows/columns.
+     * @param max_nb_threads The maximum number of threads (1 runs the
+     *                       transpose on the calling thread only).
+     */
+    template <typename T>
+    void transpose_inplace(
+      T* a,
+      const std::size_t n,
+      const std::size_t max_nb_threads = max_threads
+    ) {
+      constexpr std::size_t m = micro<T>::size;
+      constexpr std::size_t b = tile<T>();
+      const std::size_t nb_blocks = (n + b - 1) / b;
+      parallel_rows(nb_blocks, n * n / 2,
+        [&](std::size_t begin, std::size_t end) {
+          T tmp[(m > 0) ? m*m : 1];
+          for (std::size_t bi = begin; bi < end; ++bi) {
+            const std::size_t i0 = bi * b;
+            const std::size_t i1 = std::min(n, i0 + b);
+            // Diagonal block
+            for (std::size_t i = i0; i < i1; ++i) {
+              for (std::size_t j = i + 1; j < i1; ++j) {
+                std::swap(a[i*n + j], a[j*n + i]);
+              }
+            }
+            // Swap the off-diagonal blocks (i, j) and (j, i)
+            for (std::size_t j0 = i1; j0 < n; j0 += b) {
+              const std::size_t j1 = std::min(n, j0 + b);
+              std::size_t i = i0;
+              if (m > 0) {
+                for (; i + m <= i1; i += m) {
+                  std::size_t j = j0;
+                  for (; j + m <= j1; j += m) {
+                    T* aij = a + i*n + j;
+                    T* aji = a + j*n + i;
+                    micro<T>::transpose(aij, n, tmp, m);
+                    micro<T>::transpose(aji, n, aij, n);
+                    for (std::size_t r = 0; r < m; ++r) {
+                      std::copy(tmp + r*m, tmp + (r+1)*m, aji + r*n);
+                    }
+                  }
+                  for (std::size_t ii = i; ii < i + m; ++ii) {
+                    for (std::size_t jj = j; jj < j1; ++jj) {
+                      std::swap(a[ii*n + jj], a[jj*n + ii]);
+                    }
+                  }
+                }
+              }
+              for (; i < i1; ++i) {
+                for (std::size_t j = j0; j < j1; ++j) {
+                  std::swap(a[i*n + j], a[j*n + i]);
+                }
+              }
+            }
+          }
+        },
+        max_nb_threads
+      );
+    }
+
+    // Permute
+    /* ============================= */
+
+    /**
+     * @brief Permute the axes of a row-major N-d array.
+     *
+     * The output axis `k` is the input axis `order[k]`. Permutations
+     * keeping the last axis in place are performed as contiguous copies,
+     * and those moving the last axis to the second-to-last position as
+     * batches of cache-blocked 2D transposes. Other permutations use a
+     * strided gather along the innermost output axis.
+     *
+     * @tparam T The type of the array elements.
+     * @param a Pointer to the input array.
+     * @param t Pointer to the output array (must not overlap the input).
+     * @param shape The shape of the input array.
+     * @param order The permutation of the axes.
+     * @param max_nb_threads The maximum number of threads (1 runs the
+     *                       permutation on the calling thread only).
+     * @throws std::invalid_argument If `order` is not a permutation
+     *         of the axes of `shape`.
+     */
+    template <typename T>
+    void permute(
+      const T* a,
+      T* t,
+      const std::vector<std::int64_t>& shape,
+      const std::vector<std::int32_t>& order,
+      const std::size_t max_nb_threads = max_threads
+    ) {
+      const std::size_t nd = shape.size();
+      // Check the permutation
+      std::vector<bool> seen(nd, false);
+      bool valid = (order.size() == nd);
+      for (std::size_t k = 0; valid && k < nd; ++k) {
+        valid = (order[k] >= 0) && (static_cast<std::size_t>(order[k]) < nd)
+          && !seen[order[k]];
+        if (valid) {
+          seen[order[k]] = true;
+        }
+      }
+      if (!valid) {
+        std::ostringstream message;
+        message << "\nFrom tf2::kernels::permute():"
+                << "\n> Invalid order of the axes.";
+        throw std::invalid_argument(message.str());
+      }
+      if (nd == 0) {
+        t[0] = a[0];
+        return;
+      }
+      // Input strides and output shape
+      std::vector<std::size_t> stride(nd, 1), out(nd);
+      for (std::size_t k = nd - 1; k > 0; --k) {
+        stride[k-1] = stride[k] * static_cast<std::size_t>(shape[k]);
+      }
+      std::size_t size = 1;
+      for (std::size_t k = 0; k < nd; ++k) {
+        out[k] = static_cast<std::size_t>(shape[order[k]]);
+        size *= out[k];
+      }
+      if (size == 0) {
+        return;
+      }
+      // Select the inner kernel: contiguous copy (last axis in place),
+      // 2D transpose (last axis moved to the second-to-last position)
+      // or strided gather, and the number of outer output axes
+      const std::size_t last = nd - 1;
+      const bool copy = (static_cast<std::size_t>(order[last]) == last);
+      const bool tr2d = !copy && (nd > 1) &&
+        (static_cast<std::size_t>(order[nd-2]) == last);
+      const std::size_t nb_outer_axes = tr2d ? nd - 2 : nd - 1;
+      std::size_t nb_outer = 1;
+      for (std::size_t k = 0; k < nb_outer_axes; ++k) {
+        nb_outer *= out[k];
+      }
+      const std::size_t inner = size / nb_outer;
+      // Loop over the outer output indices
+      parallel_rows(nb_outer, size,
+        [&](std::size_t begin, std::size_t end) {
+          // Decode the first outer index
+          std::vector<std::size_t> idx(nb_outer_axes, 0);
+          std::size_t r = begin, offset = 0;
+          for (std::size_t k = nb_outer_axes; k-- > 0;) {
+            idx[k] = r % out[k];
+            r /= out[k];
+            offset += idx[k] * stride[order[k]];
+          }
+          for (std::size_t o = begin; o < end; ++o) {
+            const T* src = a + offset;
+            T* dst = t + o * inner;
+            if (copy) {
+              std::copy(src, src + inner, dst);
+            } else if (tr2d) {
+              const std::size_t ax = order[last];
+              transpose_block<T>(
+                src, dst, 0, out[last], 0, out[nd-2], stride[ax], out[last]
+              );
+            } else {
+              const std::size_t s = stride[order[last]];
+              for (std::size_t k = 0; k < inner; ++k) {
+                dst[k] = src[k*s];
+              }
+            }
+            // Increment the outer index
+            for (std::size_t k = nb_outer_axes; k-- > 0;) {
+              offset += stride[order[k]];
+              if (++idx[k] < out[k]) {
+                break;
+              }
+              offset -= idx[k] * stride[order[k]];
+              idx[k] = 0;
+            }
+          }
+        },
+        max_nb_threads
+      );
+    }
+
+  } // namespace kernels
+
+} // namespace tf2
+
+#endif // tf2_utils_kernels_h_
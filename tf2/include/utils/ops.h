@@ -3,6 +3,7 @@
 
 #include "../includes.h"
 #include "data.h"
+#include "kernels.h"
 
 namespace tf2 {
 
@@ -57,9 +58,9 @@ namespace tf2 {
     /**
      * @brief Transpose a 3D array according to the specified order.
      *
-     * This function transposes a 3D array based on the
-     * provided order of dimensions. The resulting transposed
-     * array has the same dimensions as the original array.
+     * This function permutes the dimensions of a 3D array based
+     * on the provided order, i.e., the dimension `k` of the
+     * transposed array is the dimension `order[k]` of the original one.
      *
      * @tparam T The type of the array elements.
      * @param array The 3D array to be transposed.
@@ -84,26 +85,35 @@ namespace tf2 {
         return tf2::data::vector_3d<T>();
       }
       // Get dimensions
-      const std::size_t dim1 = array.size();
-      const std::size_t dim2 = array[0].size();
-      const std::size_t dim3 = array[0][0].size();
-      // Create a transposed array with the same dimensions
-      tf2::data::vector_3d<T> transposed(
-        dim1, tf2::data::vector_2d<T>(
-          dim2, tf2::data::vector_1d<T>(
-            dim3
-          )
-        )
-      );
-      // Transpose the original array
-      for (std::size_t i = 0; i < dim1; ++i) {
-        for (std::size_t j = 0; j < dim2; ++j) {
-          for (std::size_t k = 0; k < dim3; ++k) {
-            auto ti = order[0] == 0 ? i : (order[0] == 1 ? j : k);
-            auto tj = order[1] == 0 ? i : (order[1] == 1 ? j : k);
-            auto tk = order[2] == 0 ? i : (order[2] == 1 ? j : k);
-            transposed[ti][tj][tk] = array[i][j][k];
-          }
+      const std::vector<std::int64_t> shape = {
+        static_cast<std::int64_t>(array.size()),
+        static_cast<std::int64_t>(array[0].size()),
+        static_cast<std::int64_t>(array[0][0].size())
+      };
+      std::vector<std::int32_t> axes(order.size());
+      for (std::size_t k = 0; k < order.size(); ++k) {
+        axes[k] = static_cast<std::int32_t>(order[k]);
+      }
+      // Permute the contiguous copy of the array
+      std::vector<T> flat;
+      flat.reserve(shape[0] * shape[1] * shape[2]);
+      for (const auto &matrix : array) {
+        for (const auto &vector : matrix) {
+          flat.insert(flat.end(), vector.begin(), vector.end());
+        }
+      }
+      std::vector<T> permuted(flat.size());
+      tf2::kernels::permute<T>(flat.data(), permuted.data(), shape, axes);
+      // Split the result
+      const std::size_t dim1 = shape[axes[0]];
+      const std::size_t dim2 = shape[axes[1]];
+      const std::size_t dim3 = shape[axes[2]];
+      tf2::data::vector_3d<T> transposed(dim1, tf2::data::vector_2d<T>(dim2));
+      auto it = permuted.cbegin();
+      for (auto &matrix : transposed) {
+        for (auto &vector : matrix) {
+          vector.assign(it, it + dim3);
+          it += dim3;
         }
       }
       return transposed;
@@ -112,19 +122,14 @@ namespace tf2 {
     /**
      * @brief Transpose a 2D array.
      *
-     * This function transposes a 2D array by converting
-     * it to a temporary 3D array, transposing the 3D array,
-     * and then converting it back to a 2D array.
+     * This function transposes a 2D array of dimensions
+     * dim1 x dim2 into a dim2 x dim1 array, walking the
+     * input by cache-sized blocks of rows and columns.
      *
      * @tparam T The type of the array elements.
      * @param array The 2D array to be transposed.
      * @return A transposed 2D array.
      *
-     * @note This function internally converts the 2D array
-     *       to a 3D array, transposes it, and then converts
-     *       it back to a 2D array. The resulting transposed
-     *       2D array has the same dimensions as the original array.
-     *
      * @warning If the input array is empty, a corresponding empty
      *          array will be returned.
      */
@@ -136,13 +141,24 @@ namespace tf2 {
       if (array.empty() || array[0].empty()) {
         return tf2::data::vector_2d<T>();
       }
-      // Convert the 2D array to a 3D array
-      tf2::data::vector_3d<T> array_3d;
-      array_3d.push_back(array);
-      // Transpose the original array
-      auto transposed_3d = transpose<T>(array_3d);
-      // Convert the 3D array to a 2D array
-      return transposed_3d[0];
+      // Get dimensions
+      const std::size_t dim1 = array.size();
+      const std::size_t dim2 = array[0].size();
+      // Perform transposition
+      constexpr std::size_t b = tf2::kernels::tile<T>();
+      tf2::data::vector_2d<T> transposed(dim2, tf2::data::vector_1d<T>(dim1));
+      for (std::size_t i0 = 0; i0 < dim1; i0 += b) {
+        const std::size_t i1 = std::min(dim1, i0 + b);
+        for (std::size_t j0 = 0; j0 < dim2; j0 += b) {
+          const std::size_t j1 = std::min(dim2, j0 + b);
+          for (std::size_t i = i0; i < i1; ++i) {
+            for (std::size_t j = j0; j < j1; ++j) {
+              transposed[j][i] = array[i][j];
+            }
+          }
+        }
+      }
+      return transposed;
     }
 
     /**
@@ -150,7 +166,8 @@ namespace tf2 {
      *
      * This function transposes a 3D array represented by a 1D 
      * vector, where the array has dimensions dim1 x dim2 x dim3.
-     * The transposed array is returned as a 1D vector.
+     * The transposed array, of dimensions dim3 x dim2 x dim1,
+     * is returned as a 1D vector.
      *
      * @tparam T The type of elements in the array.
      * @param array The input 1D vector representing the 3D array.
@@ -158,7 +175,7 @@ namespace tf2 {
      * @param dim2 The size of the second dimension.
      * @param dim3 The size of the third dimension (default is 1).
      * @return A 1D vector representing the transposed array.
-     * @thdim1 std::invalid_argument If the dimensions are invalid or the
+     * @throws std::invalid_argument If the dimensions are invalid or the
      *         input array size doesn't match the specified dimensions.
      */
     template <typename T>
@@ -177,7 +194,8 @@ namespace tf2 {
       }
       // Ensure the size of the input array matches 
       // the size defined by the dimensions
-      auto size = dim1 * dim2 * dim3;
+      const std::size_t size = static_cast<std::size_t>(dim1) *
+        static_cast<std::size_t>(dim2) * static_cast<std::size_t>(dim3);
       if (array.size() != size) {
         std::ostringstream message;
         message << "\nFrom tf2::ops::transpose():"
@@ -186,18 +204,110 @@ namespace tf2 {
       }
       // Perform transposition
       std::vector<T> transposed(size);
-      for (std::int32_t i = 0; i < dim1; ++i) {
-        for (std::int32_t j = 0; j < dim2; ++j) {
-          for (std::int32_t k = 0; k < dim3; ++k) {
-            auto ijk = i * dim2 * dim3 + j * dim3 + k;
-            auto kji = k * dim1 * dim2 + j * dim1 + i;
-            transposed[kji] = array[ijk];
-          }
-        }
+      if (dim3 == 1) {
+        tf2::kernels::transpose<T>(
+          array.data(), transposed.data(), dim1, dim2, dim2, dim1
+        );
+      } else {
+        tf2::kernels::permute<T>(
+          array.data(), transposed.data(), {dim1, dim2, dim3}, {2, 1, 0}
+        );
       }
       return transposed;
     }
 
+    /**
+     * @brief Transpose a square flattened 2D array in place.
+     *
+     * @tparam T The type of elements in the array.
+     * @param array The input 1D vector representing the dim x dim array.
+     * @param dim The size of both dimensions.
+     * @throws std::invalid_argument If the input array size doesn't
+     *         match the specified dimensions.
+     */
+    template <typename T>
+    void transpose_inplace(
+      std::vector<T>& array,
+      const std::int32_t dim
+    ) {
+      const std::size_t n = static_cast<std::size_t>(std::max(dim, 0));
+      if (array.size() != n * n) {
+        std::ostringstream message;
+        message << "\nFrom tf2::ops::transpose_inplace():"
+                << "\n> Input array size doesn't match specified dimensions.";
+        throw std::invalid_argument(message.str());
+      }
+      tf2::kernels::transpose_inplace<T>(array.data(), n);
+    }
+
+    /**
+     * @brief Transpose a strided 2D array into a strided destination buffer.
+     *
+     * This function transposes a 2D array of dimensions dim1 x dim2,
+     * stored in row-major order with `ld_array` elements between the
+     * starts of two consecutive rows, into the caller-provided buffer,
+     * which receives the dim2 x dim1 transposed array with `ld_transposed`
+     * elements between the starts of two consecutive rows. This allows
+     * gathering/scattering sub-blocks of larger arrays in a single pass.
+     *
+     * @tparam T The type of elements in the array.
+     * @param array Pointer to the input array (dim1 x dim2).
+     * @param transposed Pointer to the output array (dim2 x dim1).
+     * @param dim1 The size of the first dimension.
+     * @param dim2 The size of the second dimension.
+     * @param ld_array The row stride of the input array (>= dim2).
+     * @param ld_transposed The row stride of the output array (>= dim1).
+     * @param max_nb_threads The maximum number of threads (1 runs the
+     *                       transpose on the calling thread only).
+     *
+     * @warning The input and output buffers must not overlap.
+     */
+    template <typename T>
+    void transpose(
+      const T* array,
+      T* transposed,
+      const std::int32_t dim1,
+      const std::int32_t dim2,
+      const std::int32_t ld_array,
+      const std::int32_t ld_transposed,
+      const std::size_t max_nb_threads = tf2::kernels::max_threads
+    ) {
+      tf2::kernels::transpose<T>(
+        array,
+        transposed,
+        static_cast<std::size_t>(dim1),
+        static_cast<std::size_t>(dim2),
+        static_cast<std::size_t>(ld_array),
+        static_cast<std::size_t>(ld_transposed),
+        max_nb_threads
+      );
+    }
+
+    /**
+     * @brief Transpose a flattened 2D array into a destination buffer.
+     *
+     * This function transposes a 2D array of dimensions dim1 x dim2,
+     * stored in row-major order, into the caller-provided buffer,
+     * which receives the dim2 x dim1 transposed array.
+     *
+     * @tparam T The type of elements in the array.
+     * @param array Pointer to the input array (dim1 x dim2).
+     * @param transposed Pointer to the output array (dim2 x dim1).
+     * @param dim1 The size of the first dimension.
+     * @param dim2 The size of the second dimension.
+     *
+     * @warning The input and output buffers must not overlap.
+     */
+    template <typename T>
+    void transpose(
+      const T* array,
+      T* transposed,
+      const std::int32_t dim1,
+      const std::int32_t dim2
+    ) {
+      transpose<T>(array, transposed, dim1, dim2, dim2, dim1);
+    }
+
     // Flatten
     /* ============================= */
 
@@ -227,12 +337,23 @@ namespace tf2 {
       const std::size_t dim2 = array[0].size();
       // Perform flattening
       std::vector<T> flattened(dim1 * dim2);
-      for (std::size_t i = 0; i < dim1; ++i) {
-        for (std::size_t j = 0; j < dim2; ++j) {
-          if (transpose_in) {
-            flattened[j * dim1 + i] = array[i][j];
-          } else {
-            flattened[i * dim2 + j] = array[i][j];
+      if (!transpose_in) {
+        for (std::size_t i = 0; i < dim1; ++i) {
+          std::copy(array[i].begin(), array[i].end(), &flattened[i * dim2]);
+        }
+        return flattened;
+      }
+      // Transpose by cache-sized blocks of rows
+      constexpr std::size_t b = tf2::kernels::tile<T>();
+      for (std::size_t i0 = 0; i0 < dim1; i0 += b) {
+        const std::size_t i1 = std::min(dim1, i0 + b);
+        for (std::size_t j0 = 0; j0 < dim2; j0 += b) {
+          const std::size_t j1 = std::min(dim2, j0 + b);
+          for (std::size_t i = i0; i < i1; ++i) {
+            const T* row = array[i].data();
+            for (std::size_t j = j0; j < j1; ++j) {
+              flattened[j * dim1 + i] = row[j];
+            }
           }
         }
       }
@@ -274,7 +395,7 @@ namespace tf2 {
       const std::int32_t dim2 = shape[1];
       // Ensure the size of the input vector
       // matches the size defined by the shape
-      if (dim1 * dim2 != vector.size()) {
+      if (static_cast<std::size_t>(dim1) * dim2 != vector.size()) {
         message << "\n> Input array size doesn't match specified dimensions.";
         throw std::invalid_argument(message.str());
       }
@@ -319,7 +440,11 @@ namespace tf2 {
       if ((dim2 > 1 && col2row) || (dim1 > 1 && !col2row)) {
         // Transpose the matrix to convert
         // between row-major and column-major
-        x = std::move(transpose<T>(x, dim1, dim2));
+        if (dim1 == dim2) {
+          transpose_inplace<T>(x, dim1);
+        } else {
+          x = transpose<T>(x, dim1, dim2);
+        }
       }
     }
 
@@ -0,0 +1,229 @@
+#ifndef tf2_utils_proto_h_
+#define tf2_utils_proto_h_
+
+#include "../includes.h"
+
+namespace tf2 {
+
+  /**
+   * @brief Minimal protocol buffers wire-format helpers.
+   *
+   * TensorFlow exchanges graphs and configurations through serialized
+   * protocol buffers. These helpers write the few messages tf2 builds
+   * itself, and read the few it inspects (e.g., run metadata), without
+   * depending on the protobuf library.
+   */
+  namespace proto {
+
+    // Wire types
+    enum wire_type : std::uint8_t {
+      varint = 0,
+      fixed64 = 1,
+      length_delimited = 2,
+      fixed32 = 5
+    };
+
+    // Write
+    /* ============================= */
+
+    /**
+     * @brief Append a base-128 varint.
+     *
+     * @param buffer The serialized message.
+     * @param value The value to append.
+     */
+    inline void write_varint(
+      std::string& buffer,
+      std::uint64_t value
+    ) {
+      while (value >= 0x80) {
+        buffer.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+      }
+      buffer.push_back(static_cast<char>(value));
+    }
+
+    /**
+     * @brief Append a field key.
+     *
+     * @param buffer The serialized message.
+     * @param field The field number.
+     * @param type The wire type.
+     */
+    inline void write_key(
+      std::string& buffer,
+      const std::uint32_t field,
+      const wire_type type
+    ) {
+      write_varint(buffer, (static_cast<std::uint64_t>(field) << 3) | type);
+    }
+
+    /**
+     * @brief Append an integer field (int32, int64, uint32, uint64,
+     *        bool or enum).
+     *
+     * Negative values are encoded on ten bytes, as int32 and
+     * int64 fields are.
+     *
+     * @param buffer The serialized message.
+     * @param field The field number.
+     * @param value The field value.
+     */
+    inline void write_int(
+      std::string& buffer,
+      const std::uint32_t field,
+      const std::int64_t value
+    ) {
+      write_key(buffer, field, varint);
+      write_varint(buffer, static_cast<std::uint64_t>(value));
+    }
+
+    /**
+     * @brief Append a length-delimited field (string, bytes or message).
+     *
+     * @param buffer The serialized message.
+     * @param field The field number.
+     * @param data Pointer to the field content.
+     * @param size The size of the field content in bytes.
+     */
+    inline void write_bytes(
+      std::string& buffer,
+      const std::uint32_t field,
+      const void* data,
+      const std::size_t size
+    ) {
+      write_key(buffer, field, length_delimited);
+      write_varint(buffer, size);
+      buffer.append(static_cast<const char*>(data), size);
+    }
+
+    inline void write_bytes(
+      std::string& buffer,
+      const std::uint32_t field,
+      const std::string& data
+    ) {
+      write_bytes(buffer, field, data.data(), data.size());
+    }
+
+    // Read
+    /* ============================= */
+
+    /**
+     * @brief A decoded field.
+     *
+     * Varint and fixed fields hold their value in `value`;
+     * length-delimited fields point into the message through
+     * `data` and `size`.
+     */
+    struct field {
+      std::uint32_t number = 0;
+      wire_type type = varint;
+      std::uint64_t value = 0;
+      const char* data = nullptr;
+      std::size_t size = 0;
+    };
+
+    /**
+     * @brief Read a base-128 varint.
+     *
+     * @param pos The read position, advanced past the varint.
+     * @param end The end of the message.
+     * @param value The decoded value.
+     * @return False if the message ends within the varint.
+     */
+    inline bool read_varint(
+      const char*& pos,
+      const char* end,
+      std::uint64_t& value
+    ) {
+      value = 0;
+      for (int shift = 0; (pos < end) && (shift < 64); shift += 7) {
+        const std::uint8_t byte = static_cast<std::uint8_t>(*pos++);
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    /**
+     * @brief Sequential reader of the fields of a serialized message.
+     *
+     * Nested messages are read by constructing a reader over the
+     * content of their (length-delimited) field.
+     */
+    class reader {
+
+    public:
+
+      reader(const void* data, const std::size_t size)
+        : pos(static_cast<const char*>(data)),
+          end(static_cast<const char*>(data) + size) {}
+
+      explicit reader(const field& f) : reader(f.data, f.size) {}
+
+      /**
+       * @brief Read the next field.
+       *
+       * @param f The decoded field.
+       * @return False at the end of the message (or if it is malformed).
+       */
+      bool next(field& f) {
+        std::uint64_t key;
+        if (
+          (this->pos >= this->end) ||
+          !read_varint(this->pos, this->end, key)
+        ) {
+          return false;
+        }
+        f.number = static_cast<std::uint32_t>(key >> 3);
+        f.type = static_cast<wire_type>(key & 0x7);
+        f.data = nullptr;
+        f.size = 0;
+        switch (f.type) {
+          case varint:
+            return read_varint(this->pos, this->end, f.value);
+          case fixed64:
+          case fixed32: {
+            const std::size_t n = (f.type == fixed64) ? 8 : 4;
+            if (static_cast<std::size_t>(this->end - this->pos) < n) {
+              return false;
+            }
+            f.value = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+              f.value |= static_cast<std::uint64_t>(
+                static_cast<std::uint8_t>(this->pos[i])
+              ) << (8 * i);
+            }
+            this->pos += n;
+            return true;
+          }
+          case length_delimited:
+            if (
+              !read_varint(this->pos, this->end, f.value) ||
+              (f.value > static_cast<std::uint64_t>(this->end - this->pos))
+            ) {
+              return false;
+            }
+            f.data = this->pos;
+            f.size = static_cast<std::size_t>(f.value);
+            this->pos += f.size;
+            return true;
+          default:
+            return false;
+        }
+      }
+
+    private:
+
+      const char* pos;
+      const char* end;
+
+    };
+
+  } // namespace proto
+
+} // namespace tf2
+
+#endif // tf2_utils_proto_h_
@@ -0,0 +1,150 @@
+#ifndef tf2_workspace_h_
+#define tf2_workspace_h_
+
+#include "includes.h"
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <tensorflow/c/c_api.h>
+
+namespace tf2 {
+
+  /**
+   * @brief Persistent per-model workspace for allocation-free inference.
+   *
+   * The workspace owns two kinds of reusable memory:
+   *
+   * 1. Pools of tensor buffers, keyed by datatype and capacity. The
+   *    capacities are rounded up to a power of two, and a tensor is
+   *    created with `TF_NewTensor` on the smallest free buffer at least
+   *    as large as needed. Its deallocator returns the buffer to its
+   *    pool instead of freeing it.
+   *
+   * 2. A set of host scratch arrays, identified by a slot index, which
+   *    only grow when a larger size is requested.
+   *
+   * After a warm-up call, repeated calls with the same shapes do not
+   * allocate any memory on the tf2 side, which can be verified through
+   * `nb_allocs()` (see the `msd_c_steady` example). Calls with varying
+   * shapes reuse the buffers of the larger ones, so that the number of
+   * pools is bounded by the number of capacities (at most a few tens)
+   * and the memory stops growing once the largest shapes were seen.
+   */
+  class workspace {
+
+  public:
+
+    // Constructors
+    workspace() = default;
+    workspace(const workspace&) = delete;
+    workspace& operator=(const workspace&) = delete;
+
+    // Destructor
+    ~workspace();
+
+    /**
+     * @brief Create a tensor on a pooled buffer.
+     *
+     * @param dtype The tensor datatype.
+     * @param shape The tensor shape.
+     * @param nb_dims The number of dimensions.
+     * @return A tensor, to be released with `TF_DeleteTensor`.
+     */
+    TF_Tensor* new_tensor(
+      const TF_DataType dtype,
+      const std::int64_t* shape,
+      const int nb_dims
+    );
+
+    /**
+     * @brief Get a reusable host scratch array.
+     *
+     * @tparam T The type of the array elements.
+     * @param slot The index of the scratch array.
+     * @param size The minimum number of elements.
+     * @return Pointer to the scratch array.
+     *
+     * @warning The content of the array is not preserved when
+     *          it has to grow.
+     */
+    template <typename T>
+    T* scratch(
+      const std::size_t slot,
+      const std::size_t size
+    ) {
+      if (slot >= this->scratch_arrays.size()) {
+        this->scratch_arrays.resize(slot + 1);
+        this->scratch_sizes.resize(slot + 1, 0);
+      }
+      const std::size_t len = size * sizeof(T);
+      if (this->scratch_sizes[slot] < len) {
+        this->scratch_arrays[slot] = buffer_ptr(this->allocate(len));
+        this->scratch_sizes[slot] = len;
+      }
+      return static_cast<T*>(this->scratch_arrays[slot].get());
+    }
+
+    /**
+     * @brief Free the pooled buffers which are not in use.
+     *
+     * The buffers of the tensors still alive are returned to their
+     * pool as usual, and the next requests allocate again.
+     */
+    void trim();
+
+    /**
+     * @brief Number of heap allocations performed so far.
+     *
+     * This counter is meant to check that the steady state of the
+     * inference is allocation-free: it should not change between
+     * repeated calls with at most the number of points already seen.
+     */
+    std::size_t nb_allocs() const { return this->allocs; }
+
+    /**
+     * @brief Number of tensors served from a pooled buffer so far.
+     */
+    std::size_t nb_reuses() const { return this->reuses; }
+
+    // Alignment of the allocated buffers (TensorFlow copies
+    // the data of tensors which are not aligned to it)
+    static constexpr std::size_t alignment = 64;
+
+  private:
+
+    struct buffer_deleter {
+      void operator()(void* data) const;
+    };
+    using buffer_ptr = std::unique_ptr<void, buffer_deleter>;
+
+    // Free list of the buffers sharing the same datatype and capacity
+    struct pool {
+      tf2::workspace* owner;
+      std::size_t len;
+      std::size_t nb_buffers;
+      std::vector<void*> buffers;
+    };
+
+    // Tensor buffers pools, keyed by {datatype, capacity}
+    using pool_key = std::pair<TF_DataType, std::size_t>;
+    std::map<pool_key, pool> pools;
+    std::mutex lock;
+
+    // Host scratch arrays
+    std::vector<buffer_ptr> scratch_arrays;
+    std::vector<std::size_t> scratch_sizes;
+
+    // Counters
+    std::atomic<std::size_t> allocs{0};
+    std::atomic<std::size_t> reuses{0};
+
+    void* allocate(const std::size_t len);
+
+    static void release(void* data, std::size_t len, void* arg);
+
+  };
+
+} // namespace tf2
+
+#endif // tf2_workspace_h_
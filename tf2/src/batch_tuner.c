@@ -0,0 +1,74 @@
+#include <algorithm>
+#include "batch_tuner.h"
+
+
+// Calibration
+// ====================================
+std::vector<std::int32_t> tf2::batch_tuner::candidates(
+  const std::int32_t max_size
+) {
+  std::vector<std::int32_t> sizes;
+  for (std::int64_t b = 16; b <= max_size; b *= 2) {
+    sizes.push_back(static_cast<std::int32_t>(b));
+  }
+  if (sizes.empty() && (max_size > 0)) {
+    sizes.push_back(max_size);
+  }
+  return sizes;
+}
+
+void tf2::batch_tuner::record(
+  const std::int32_t batch_size,
+  const std::int32_t nb_pts,
+  const double seconds
+) {
+  if (seconds <= 0.0) {
+    return;
+  }
+  const double rate = nb_pts / seconds;
+  auto it = std::lower_bound(
+    this->points.begin(),
+    this->points.end(),
+    batch_size,
+    [](const point& p, const std::int32_t b) { return p.batch_size < b; }
+  );
+  if ((it == this->points.end()) || (it->batch_size != batch_size)) {
+    this->points.insert(it, point{batch_size, rate, 1});
+  } else {
+    it->pts_per_sec += tf2::batch_tuner::smoothing * (rate - it->pts_per_sec);
+    it->nb_samples++;
+  }
+}
+
+// Selection
+// ====================================
+std::int32_t tf2::batch_tuner::best() const {
+  auto it = std::max_element(
+    this->points.begin(),
+    this->points.end(),
+    [](const point& a, const point& b) { return a.pts_per_sec < b.pts_per_sec; }
+  );
+  return (it == this->points.end()) ? -1 : it->batch_size;
+}
+
+std::int32_t tf2::batch_tuner::next() {
+  const std::int32_t b = this->best();
+  this->nb_calls++;
+  if ((b < 1) || (this->nb_calls % tf2::batch_tuner::explore_period != 0)) {
+    return b;
+  }
+  // Explore the smaller and larger neighbours in turn
+  const bool larger = (this->nb_calls / tf2::batch_tuner::explore_period) % 2;
+  auto it = std::find_if(
+    this->points.begin(),
+    this->points.end(),
+    [b](const point& p) { return p.batch_size == b; }
+  );
+  if (larger && (it + 1 != this->points.end())) {
+    return (it + 1)->batch_size;
+  }
+  if (!larger && (it != this->points.begin())) {
+    return (it - 1)->batch_size;
+  }
+  return b;
+}
@@ -0,0 +1,131 @@
+#include <atomic>
+#include <cstring>
+#include <numeric>
+#include <filesystem>
+#include <unistd.h>
+#include "client.h"
+
+
+// Constructor
+// ====================================
+tf2::client::client(
+  const std::string& socket_path,
+  const std::string& inpfile
+) {
+  this->fd = tf2::ipc::connect(socket_path);
+  // Open the model (the daemon may run in another directory)
+  std::string answer;
+  try {
+    this->exchange(
+      {tf2::ipc::open, 0, 0, 0, 0, 0},
+      std::filesystem::absolute(inpfile).string(),
+      answer
+    );
+  } catch (...) {
+    ::close(this->fd);
+    throw;
+  }
+  // Dimensions: {nb_inputs, nb_outputs, inputs_dim..., outputs_dim...}
+  std::vector<std::int32_t> dims(answer.size() / sizeof(std::int32_t));
+  std::memcpy(dims.data(), answer.data(), answer.size());
+  this->inputs_dim.assign(dims.begin() + 2, dims.begin() + 2 + dims[0]);
+  this->outputs_dim.assign(dims.begin() + 2 + dims[0], dims.end());
+  this->inp_tot_dim = std::accumulate(
+    this->inputs_dim.begin(), this->inputs_dim.end(), 0
+  );
+  this->out_tot_dim = std::accumulate(
+    this->outputs_dim.begin(), this->outputs_dim.end(), 0
+  );
+}
+
+// Destructor
+// ====================================
+tf2::client::~client() {
+  ::close(this->fd);
+}
+
+// Calling
+// ====================================
+template <typename T>
+void tf2::client::call(
+  const T* inputs,
+  T* outputs,
+  const std::int32_t nb_pts
+) {
+  const std::size_t nb_inputs = static_cast<std::size_t>(nb_pts) *
+    this->inp_tot_dim;
+  const std::size_t nb_outputs = static_cast<std::size_t>(nb_pts) *
+    this->out_tot_dim;
+  // Inputs, followed by the outputs at the next aligned offset
+  const std::size_t inputs_size = tf2::ipc::align(nb_inputs * sizeof(T));
+  const std::size_t offset = this->reserve(
+    inputs_size + nb_outputs * sizeof(T)
+  );
+  char* data = static_cast<char*>(this->shm->data()) + offset;
+  std::memcpy(data, inputs, nb_inputs * sizeof(T));
+  std::string answer;
+  this->exchange(
+    {tf2::ipc::call, sizeof(T), nb_pts, 0, offset, 0}, "", answer
+  );
+  std::memcpy(outputs, data + inputs_size, nb_outputs * sizeof(T));
+}
+
+void tf2::client::exchange(
+  tf2::ipc::request req,
+  const std::string& payload,
+  std::string& answer
+) {
+  req.length = payload.size();
+  tf2::ipc::send_all(this->fd, &req, sizeof(req));
+  tf2::ipc::send_all(this->fd, payload.data(), payload.size());
+  tf2::ipc::reply rep;
+  tf2::ipc::recv_all(this->fd, &rep, sizeof(rep));
+  answer.resize(rep.length);
+  tf2::ipc::recv_all(this->fd, &answer[0], answer.size());
+  if (rep.status != 0) {
+    throw std::runtime_error(answer);
+  }
+}
+
+std::size_t tf2::client::reserve(
+  const std::size_t size
+) {
+  // Grow the segment, to twice the largest payload
+  if (!this->shm || (this->shm->size() < size)) {
+    static std::atomic<std::size_t> counter{0};
+    const std::string name = "/tf2-" + std::to_string(::getpid()) + "-" +
+      std::to_string(counter++);
+    this->shm.reset();
+    this->shm = std::unique_ptr<tf2::ipc::shared_memory>(
+      new tf2::ipc::shared_memory(name, 2 * tf2::ipc::align(size), true)
+    );
+    std::string answer;
+    this->exchange(
+      {tf2::ipc::map, 0, 0, 0, this->shm->size(), 0}, name, answer
+    );
+    // Mapped by both processes: the name is no longer needed
+    this->shm->unlink();
+    this->head = 0;
+  }
+  // Wrap around the ring
+  if (this->head + size > this->shm->size()) {
+    this->head = 0;
+  }
+  const std::size_t offset = this->head;
+  this->head = tf2::ipc::align(this->head + size);
+  return offset;
+}
+
+// Explicit templates instantiation
+// ====================================
+template void tf2::client::call(
+  const float* inputs,
+  float* outputs,
+  const std::int32_t nb_pts
+);
+
+template void tf2::client::call(
+  const double* inputs,
+  double* outputs,
+  const std::int32_t nb_pts
+);
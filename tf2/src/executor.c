@@ -0,0 +1,54 @@
+#include "executor.h"
+
+
+// Constructor
+// ====================================
+tf2::executor::executor() {
+  this->worker = std::thread(&tf2::executor::loop, this);
+}
+
+// Destructor
+// ====================================
+tf2::executor::~executor() {
+  {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->stop = true;
+  }
+  this->wake.notify_one();
+  this->worker.join();
+}
+
+// Tasks
+// ====================================
+std::shared_future<void> tf2::executor::submit(
+  std::function<void()> task
+) {
+  std::packaged_task<void()> job(std::move(task));
+  std::shared_future<void> result = job.get_future().share();
+  {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->tasks.push_back(std::move(job));
+  }
+  this->wake.notify_one();
+  return result;
+}
+
+void tf2::executor::loop() {
+  while (true) {
+    std::packaged_task<void()> job;
+    {
+      std::unique_lock<std::mutex> guard(this->lock);
+      this->wake.wait(guard, [this]() {
+        return this->stop || !this->tasks.empty();
+      });
+      // Stop once the pending tasks are done
+      if (this->tasks.empty()) {
+        return;
+      }
+      job = std::move(this->tasks.front());
+      this->tasks.pop_front();
+    }
+    // Exceptions are stored in the shared state of the future
+    job();
+  }
+}
@@ -0,0 +1,257 @@
+#include <set>
+#include <mutex>
+#include <memory>
+#include <cppflow/cppflow.h>
+#include "graph.h"
+#include "signature.h"
+#include "utils/proto.h"
+
+namespace {
+
+  using status_ptr = std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)>;
+  using buffer_ptr = std::unique_ptr<TF_Buffer, decltype(&TF_DeleteBuffer)>;
+  using options_ptr = std::unique_ptr<
+    TF_ImportGraphDefOptions, decltype(&TF_DeleteImportGraphDefOptions)
+  >;
+
+  bool same_endpoint(const TF_Output& a, const TF_Output& b) {
+    return (a.oper == b.oper) && (a.index == b.index);
+  }
+
+  // Operations lying on a path from the inputs to the outputs
+  std::set<TF_Operation*> path_ops(
+    const std::vector<TF_Output>& inputs,
+    const std::vector<TF_Output>& outputs
+  ) {
+    std::set<TF_Operation*> sources;
+    for (const auto &i : inputs) {
+      sources.insert(i.oper);
+    }
+    // Forward pass: operations depending on the inputs
+    std::set<TF_Operation*> fwd;
+    std::vector<TF_Operation*> stack;
+    auto visit = [&](TF_Operation* op) {
+      if (!sources.count(op) && fwd.insert(op).second) {
+        stack.push_back(op);
+      }
+    };
+    auto visit_consumers = [&](const TF_Output& out) {
+      std::vector<TF_Input> consumers(TF_OperationOutputNumConsumers(out));
+      TF_OperationOutputConsumers(
+        out, consumers.data(), static_cast<int>(consumers.size())
+      );
+      for (const auto &c : consumers) {
+        visit(c.oper);
+      }
+    };
+    for (const auto &i : inputs) {
+      visit_consumers(i);
+    }
+    while (!stack.empty()) {
+      TF_Operation* op = stack.back();
+      stack.pop_back();
+      for (int k = 0; k < TF_OperationNumOutputs(op); ++k) {
+        visit_consumers({op, k});
+      }
+      std::vector<TF_Operation*> ctrl(TF_OperationNumControlOutputs(op));
+      TF_OperationGetControlOutputs(
+        op, ctrl.data(), static_cast<int>(ctrl.size())
+      );
+      for (auto c : ctrl) {
+        visit(c);
+      }
+    }
+    // Backward pass: operations the outputs depend on
+    std::set<TF_Operation*> path;
+    auto visit_back = [&](TF_Operation* op) {
+      if (fwd.count(op) && path.insert(op).second) {
+        stack.push_back(op);
+      }
+    };
+    for (const auto &o : outputs) {
+      visit_back(o.oper);
+    }
+    while (!stack.empty()) {
+      TF_Operation* op = stack.back();
+      stack.pop_back();
+      for (int k = 0; k < TF_OperationNumInputs(op); ++k) {
+        visit_back(TF_OperationInput({op, k}).oper);
+      }
+      std::vector<TF_Operation*> ctrl(TF_OperationNumControlInputs(op));
+      TF_OperationGetControlInputs(
+        op, ctrl.data(), static_cast<int>(ctrl.size())
+      );
+      for (auto c : ctrl) {
+        visit_back(c);
+      }
+    }
+    return path;
+  }
+
+  TF_Output add_transpose(
+    TF_Graph* graph,
+    const std::string& name,
+    const TF_Output x,
+    const TF_Output perm,
+    TF_Status* status
+  ) {
+    TF_OperationDescription* desc = TF_NewOperation(
+      graph, "Transpose", name.c_str()
+    );
+    TF_AddInput(desc, x);
+    TF_AddInput(desc, perm);
+    TF_Operation* op = TF_FinishOperation(desc, status);
+    cppflow::status_check(status);
+    return {op, 0};
+  }
+
+} // namespace
+
+
+tf2::graph::endpoints tf2::graph::transpose_io(
+  TF_Graph* graph,
+  const std::vector<std::string>& inputs_id,
+  const std::vector<std::string>& outputs_id,
+  const std::vector<std::int32_t>& inputs_dim,
+  const std::string& prefix
+) {
+  // Serialize the rewrites, as models sharing a graph may be
+  // created concurrently
+  static std::mutex lock;
+  std::lock_guard<std::mutex> guard(lock);
+  status_ptr status(TF_NewStatus(), &TF_DeleteStatus);
+  // Number the name scope if already used (e.g., by another
+  // model sharing the graph)
+  std::string root = prefix;
+  for (
+    int n = 1;
+    TF_GraphOperationByName(graph, (root + "/perm").c_str()) != nullptr;
+    ++n
+  ) {
+    root = prefix + "_" + std::to_string(n);
+  }
+  // Resolve the original endpoints
+  std::vector<TF_Output> inputs, outputs;
+  for (const auto &i_id : inputs_id) {
+    inputs.push_back(tf2::signature::resolve(graph, i_id));
+  }
+  for (const auto &o_id : outputs_id) {
+    outputs.push_back(tf2::signature::resolve(graph, o_id));
+  }
+  tf2::graph::endpoints result;
+  // Permutation of the transposes
+  TF_Output perm;
+  {
+    const std::int64_t dims[1] = {2};
+    TF_Tensor* value = TF_AllocateTensor(
+      TF_INT32, dims, 1, 2 * sizeof(std::int32_t)
+    );
+    std::int32_t* data = static_cast<std::int32_t*>(TF_TensorData(value));
+    data[0] = 1;
+    data[1] = 0;
+    const std::string name = root + "/perm";
+    TF_OperationDescription* desc = TF_NewOperation(
+      graph, "Const", name.c_str()
+    );
+    TF_SetAttrTensor(desc, "value", value, status.get());
+    TF_DeleteTensor(value);
+    cppflow::status_check(status.get());
+    TF_SetAttrType(desc, "dtype", TF_INT32);
+    perm = {TF_FinishOperation(desc, status.get()), 0};
+    cppflow::status_check(status.get());
+  }
+  // Column-major placeholders, transposed to the model inputs layout
+  std::vector<TF_Output> transposed;
+  for (std::size_t i = 0; i < inputs.size(); ++i) {
+    const std::string name = root + "/input_" + std::to_string(i);
+    TF_OperationDescription* desc = TF_NewOperation(
+      graph, "Placeholder", name.c_str()
+    );
+    const std::int64_t shape[2] = {inputs_dim[i], -1};
+    TF_SetAttrType(desc, "dtype", TF_OperationOutputType(inputs[i]));
+    TF_SetAttrShape(desc, "shape", shape, 2);
+    const TF_Output x = {TF_FinishOperation(desc, status.get()), 0};
+    cppflow::status_check(status.get());
+    transposed.push_back(
+      add_transpose(graph, name + "/transpose", x, perm, status.get())
+    );
+    result.inputs_id.push_back(name + ":0");
+  }
+  // Clone the operations depending on the inputs, with their
+  // inputs remapped to the transposed placeholders
+  const std::set<TF_Operation*> path = path_ops(inputs, outputs);
+  const std::string scope = root + "/graph";
+  if (!path.empty()) {
+    std::string graph_def;
+    options_ptr opts(
+      TF_NewImportGraphDefOptions(), &TF_DeleteImportGraphDefOptions
+    );
+    TF_ImportGraphDefOptionsSetPrefix(opts.get(), scope.c_str());
+    TF_ImportGraphDefOptionsSetValidateColocationConstraints(opts.get(), 0);
+    for (TF_Operation* op : path) {
+      // > Node definition
+      buffer_ptr node_def(TF_NewBuffer(), &TF_DeleteBuffer);
+      TF_OperationToNodeDef(op, node_def.get(), status.get());
+      cppflow::status_check(status.get());
+      tf2::proto::write_bytes(
+        graph_def, 1, node_def->data, node_def->length
+      );
+      // > Inputs from outside the path
+      for (int k = 0; k < TF_OperationNumInputs(op); ++k) {
+        const TF_Output src = TF_OperationInput({op, k});
+        if (path.count(src.oper)) {
+          continue;
+        }
+        TF_Output dst = src;
+        for (std::size_t i = 0; i < inputs.size(); ++i) {
+          if (same_endpoint(src, inputs[i])) {
+            dst = transposed[i];
+          }
+        }
+        TF_ImportGraphDefOptionsAddInputMapping(
+          opts.get(), TF_OperationName(src.oper), src.index, dst
+        );
+      }
+      std::vector<TF_Operation*> ctrl(TF_OperationNumControlInputs(op));
+      TF_OperationGetControlInputs(
+        op, ctrl.data(), static_cast<int>(ctrl.size())
+      );
+      for (auto c : ctrl) {
+        if (!path.count(c)) {
+          TF_ImportGraphDefOptionsRemapControlDependency(
+            opts.get(), TF_OperationName(c), c
+          );
+        }
+      }
+    }
+    // > Graph versions
+    buffer_ptr versions(TF_NewBuffer(), &TF_DeleteBuffer);
+    TF_GraphVersions(graph, versions.get(), status.get());
+    cppflow::status_check(status.get());
+    tf2::proto::write_bytes(graph_def, 4, versions->data, versions->length);
+    // > Import the clones
+    buffer_ptr buffer(
+      TF_NewBufferFromString(graph_def.data(), graph_def.size()),
+      &TF_DeleteBuffer
+    );
+    TF_GraphImportGraphDef(graph, buffer.get(), opts.get(), status.get());
+    cppflow::status_check(status.get());
+  }
+  // Transpose the outputs to column-major
+  for (std::size_t i = 0; i < outputs.size(); ++i) {
+    TF_Output y = outputs[i];
+    if (path.count(y.oper)) {
+      const std::string name = scope + "/" + TF_OperationName(y.oper);
+      y.oper = TF_GraphOperationByName(graph, name.c_str());
+    }
+    for (std::size_t j = 0; j < inputs.size(); ++j) {
+      if (same_endpoint(outputs[i], inputs[j])) {
+        y = transposed[j];
+      }
+    }
+    const std::string name = root + "/output_" + std::to_string(i);
+    add_transpose(graph, name, y, perm, status.get());
+    result.outputs_id.push_back(name + ":0");
+  }
+  return result;
+}
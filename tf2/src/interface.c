@@ -14,8 +14,12 @@ std::int32_t tf2::get_out_tot_dim(tf2::model *mdl) {
   return mdl->out_tot_dim;
 }
 
+std::int32_t tf2::get_batch_size(tf2::model *mdl) {
+  return mdl->get_batch_size();
+}
+
 void tf2::delete_model(tf2::model *mdl) {
-  mdl->~model();
+  delete mdl;
 }
 
 void tf2::call_model_float(
@@ -24,13 +28,8 @@ void tf2::call_model_float(
   float *inputs,
   float *outputs
 ) {
-  // Convert input and output arrays to vectors
-  std::vector<float> x(inputs, inputs + mdl->inp_tot_dim * (*nb_pts));
-  std::vector<float> y(outputs, outputs + mdl->out_tot_dim * (*nb_pts));
-  // Perform in-place inference
-  mdl->call(x, y, *nb_pts);
-  // Copy the updated outputs back to the 'outputs' array
-  std::copy(y.begin(), y.end(), outputs);
+  // Perform in-place inference on the caller's arrays
+  mdl->call<float>(inputs, outputs, *nb_pts);
 }
 
 void tf2::call_model_double(
@@ -39,11 +38,54 @@ void tf2::call_model_double(
   double *inputs,
   double *outputs
 ) {
-  // Convert input and output arrays to vectors
-  std::vector<double> x(inputs, inputs + mdl->inp_tot_dim * (*nb_pts));
-  std::vector<double> y(outputs, outputs + mdl->out_tot_dim * (*nb_pts));
-  // Perform in-place inference
-  mdl->call(x, y, *nb_pts);
-  // Copy the updated outputs back to the 'outputs' array
-  std::copy(y.begin(), y.end(), outputs);
+  // Perform in-place inference on the caller's arrays
+  mdl->call<double>(inputs, outputs, *nb_pts);
+}
+
+void tf2::call_model_float_async(
+  tf2::model *mdl,
+  std::int32_t *nb_pts,
+  float *inputs,
+  float *outputs
+) {
+  // Queue in-place inference on the caller's arrays
+  mdl->call_async<float>(inputs, outputs, *nb_pts);
+}
+
+void tf2::call_model_double_async(
+  tf2::model *mdl,
+  std::int32_t *nb_pts,
+  double *inputs,
+  double *outputs
+) {
+  // Queue in-place inference on the caller's arrays
+  mdl->call_async<double>(inputs, outputs, *nb_pts);
+}
+
+void tf2::wait_model(tf2::model *mdl) {
+  mdl->wait();
+}
+
+void tf2::wait_model_ready(tf2::model *mdl) {
+  mdl->wait_ready();
+}
+
+void tf2::dump_model_profile(tf2::model *mdl, const char *filename) {
+  mdl->dump_profile(std::string(filename));
+}
+
+void tf2::get_model_stats(tf2::model *mdl, tf2::model_stats *stats) {
+  const tf2::metrics::snapshot s = mdl->get_stats();
+  stats->nb_calls = s.nb_calls;
+  stats->nb_pts = s.nb_pts;
+  stats->bytes_in = s.bytes_in;
+  stats->bytes_out = s.bytes_out;
+  for (std::size_t p = 0; p < tf2::metrics::nb_phases; ++p) {
+    stats->count[p] = s.count[p];
+    stats->seconds[p] = s.seconds[p];
+    stats->p50[p] = s.quantile(p, 0.50);
+    stats->p99[p] = s.quantile(p, 0.99);
+  }
+  stats->zero_copy_inputs = s.zero_copy_inputs;
+  stats->unaligned_inputs = s.unaligned_inputs;
 }
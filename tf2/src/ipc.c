@@ -0,0 +1,197 @@
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "ipc.h"
+
+namespace {
+
+  [[noreturn]] void raise(
+    const std::string& fn,
+    const std::string& what
+  ) {
+    std::ostringstream message;
+    message << "\nFrom tf2::ipc::" << fn << "():"
+            << "\n> " << what << ": " << std::strerror(errno);
+    throw std::runtime_error(message.str());
+  }
+
+  sockaddr_un address(const std::string& path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+      errno = ENAMETOOLONG;
+      raise("address", "Invalid socket path '" + path + "'");
+    }
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    return addr;
+  }
+
+} // namespace
+
+
+// Sockets
+// ====================================
+void tf2::ipc::send_all(
+  const int fd,
+  const void* data,
+  const std::size_t size
+) {
+  const char* ptr = static_cast<const char*>(data);
+  std::size_t done = 0;
+  while (done < size) {
+    const ssize_t n = ::send(fd, ptr + done, size - done, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      raise("send_all", "Connection broken");
+    }
+    done += static_cast<std::size_t>(n);
+  }
+}
+
+void tf2::ipc::recv_all(
+  const int fd,
+  void* data,
+  const std::size_t size
+) {
+  char* ptr = static_cast<char*>(data);
+  std::size_t done = 0;
+  while (done < size) {
+    const ssize_t n = ::recv(fd, ptr + done, size - done, 0);
+    if (n == 0) {
+      errno = ECONNRESET;
+      raise("recv_all", "Connection closed");
+    }
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      raise("recv_all", "Connection broken");
+    }
+    done += static_cast<std::size_t>(n);
+  }
+}
+
+int tf2::ipc::connect(const std::string& path) {
+  const sockaddr_un addr = address(path);
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    raise("connect", "Cannot create a socket");
+  }
+  if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0) {
+    ::close(fd);
+    raise("connect", "Cannot connect to the tf2d daemon at '" + path + "'");
+  }
+  return fd;
+}
+
+int tf2::ipc::listen(const std::string& path) {
+  const sockaddr_un addr = address(path);
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    raise("listen", "Cannot create a socket");
+  }
+  // Refuse to take over the socket of a running daemon, and only
+  // remove a stale socket (left by a daemon which did not exit cleanly)
+  struct stat info;
+  if ((::lstat(path.c_str(), &info) == 0) && S_ISSOCK(info.st_mode)) {
+    const int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe < 0) {
+      ::close(fd);
+      raise("listen", "Cannot create a socket");
+    }
+    const int alive = ::connect(
+      probe, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)
+    );
+    const int error = errno;
+    ::close(probe);
+    if (alive == 0) {
+      ::close(fd);
+      errno = EADDRINUSE;
+      raise("listen", "A tf2d daemon is already listening on '" + path + "'");
+    }
+    if (error == ECONNREFUSED) {
+      ::unlink(path.c_str());
+    }
+  }
+  // Bind the socket and restrict it to the user of the daemon before
+  // accepting any connection
+  if (::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0) {
+    ::close(fd);
+    raise("listen", "Cannot bind '" + path + "'");
+  }
+  if (
+    (::chmod(path.c_str(), S_IRUSR | S_IWUSR) < 0) ||
+    (::listen(fd, SOMAXCONN) < 0)
+  ) {
+    const int error = errno;
+    ::close(fd);
+    ::unlink(path.c_str());
+    errno = error;
+    raise("listen", "Cannot listen on '" + path + "'");
+  }
+  return fd;
+}
+
+// Shared memory
+// ====================================
+tf2::ipc::shared_memory::shared_memory(
+  const std::string& name,
+  const std::size_t size,
+  const bool create
+) : id(name), len(size) {
+  const int flags = create ? (O_CREAT | O_EXCL | O_RDWR) : O_RDWR;
+  const int fd = ::shm_open(name.c_str(), flags, 0600);
+  if (fd < 0) {
+    raise("shared_memory", "Cannot open the segment '" + name + "'");
+  }
+  this->linked = create;
+  // Opened segments must be at least as large as the requested size
+  // (given by the peer process), or accessing the mapping would fault
+  if (!create) {
+    struct stat info;
+    if (::fstat(fd, &info) < 0) {
+      ::close(fd);
+      raise("shared_memory", "Cannot stat the segment '" + name + "'");
+    }
+    if (static_cast<std::size_t>(info.st_size) < size) {
+      ::close(fd);
+      errno = EINVAL;
+      raise("shared_memory", "The segment '" + name + "' is too small");
+    }
+  }
+  if (create && (::ftruncate(fd, static_cast<off_t>(size)) < 0)) {
+    ::close(fd);
+    this->unlink();
+    raise("shared_memory", "Cannot size the segment '" + name + "'");
+  }
+  this->addr = ::mmap(
+    nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0
+  );
+  ::close(fd);
+  if (this->addr == MAP_FAILED) {
+    this->addr = nullptr;
+    this->unlink();
+    raise("shared_memory", "Cannot map the segment '" + name + "'");
+  }
+}
+
+tf2::ipc::shared_memory::~shared_memory() {
+  if (this->addr != nullptr) {
+    ::munmap(this->addr, this->len);
+  }
+  this->unlink();
+}
+
+void tf2::ipc::shared_memory::unlink() {
+  if (this->linked) {
+    ::shm_unlink(this->id.c_str());
+    this->linked = false;
+  }
+}
@@ -0,0 +1,252 @@
+#include <cstdio>
+#include <cmath>
+#include "metrics.h"
+
+namespace {
+
+  // Bucket of a duration: the first power-of-two
+  // number of microseconds not lower than it
+  std::size_t bucket_of(const std::uint64_t ns) {
+    const std::uint64_t us = (ns + 999) / 1000;
+    std::size_t k = 0;
+    while ((k + 1 < tf2::metrics::nb_buckets) && ((1ull << k) < us)) {
+      ++k;
+    }
+    return k;
+  }
+
+  // Prometheus label value (backslashes, quotes and newlines escaped)
+  std::string escape(const std::string& value) {
+    std::string escaped;
+    for (const char c : value) {
+      if (c == '\n') {
+        escaped += "\\n";
+      } else {
+        if ((c == '\\') || (c == '"')) {
+          escaped.push_back('\\');
+        }
+        escaped.push_back(c);
+      }
+    }
+    return escaped;
+  }
+
+} // namespace
+
+
+// Constants
+// ====================================
+double tf2::metrics::bucket_bound(const std::size_t k) {
+  if (k + 1 >= tf2::metrics::nb_buckets) {
+    return std::numeric_limits<double>::infinity();
+  }
+  return std::ldexp(1.0e-6, static_cast<int>(k));
+}
+
+const char* tf2::metrics::phase_name(const std::size_t p) {
+  static const char* names[nb_phases] = {
+    "compose_inputs", "session_run", "compose_outputs", "copies", "call"
+  };
+  return (p < nb_phases) ? names[p] : "?";
+}
+
+// Destructor
+// ====================================
+tf2::metrics::~metrics() {
+  this->stop_dump();
+}
+
+// Recording
+// ====================================
+void tf2::metrics::add_call(
+  const std::uint64_t nb_pts,
+  const std::uint64_t bytes_in,
+  const std::uint64_t bytes_out
+) {
+  this->nb_calls.fetch_add(1, std::memory_order_relaxed);
+  this->nb_pts.fetch_add(nb_pts, std::memory_order_relaxed);
+  this->bytes_in.fetch_add(bytes_in, std::memory_order_relaxed);
+  this->bytes_out.fetch_add(bytes_out, std::memory_order_relaxed);
+}
+
+void tf2::metrics::add_zero_copy(
+  const bool wrapped
+) {
+  if (wrapped) {
+    this->zero_copy_inputs.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    this->unaligned_inputs.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+tf2::metrics::clock::time_point tf2::metrics::observe(
+  const phase p,
+  const clock::time_point start
+) {
+  const clock::time_point stop = clock::now();
+  const std::uint64_t ns = static_cast<std::uint64_t>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count()
+  );
+  this->count[p].fetch_add(1, std::memory_order_relaxed);
+  this->nanoseconds[p].fetch_add(ns, std::memory_order_relaxed);
+  this->buckets[p][bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+  return stop;
+}
+
+// Reading
+// ====================================
+tf2::metrics::snapshot tf2::metrics::read() const {
+  snapshot s;
+  s.nb_calls = this->nb_calls.load(std::memory_order_relaxed);
+  s.nb_pts = this->nb_pts.load(std::memory_order_relaxed);
+  s.bytes_in = this->bytes_in.load(std::memory_order_relaxed);
+  s.bytes_out = this->bytes_out.load(std::memory_order_relaxed);
+  s.zero_copy_inputs = this->zero_copy_inputs.load(std::memory_order_relaxed);
+  s.unaligned_inputs = this->unaligned_inputs.load(std::memory_order_relaxed);
+  for (std::size_t p = 0; p < nb_phases; ++p) {
+    s.count[p] = this->count[p].load(std::memory_order_relaxed);
+    s.seconds[p] = 1.0e-9 * this->nanoseconds[p].load(
+      std::memory_order_relaxed
+    );
+    for (std::size_t k = 0; k < nb_buckets; ++k) {
+      s.buckets[p][k] = this->buckets[p][k].load(std::memory_order_relaxed);
+    }
+  }
+  return s;
+}
+
+double tf2::metrics::snapshot::quantile(
+  const std::size_t p,
+  const double q
+) const {
+  std::uint64_t total = 0;
+  for (const auto n : this->buckets[p]) {
+    total += n;
+  }
+  if (total == 0) {
+    return 0.0;
+  }
+  const double rank = std::max(q, 0.0) * total;
+  std::uint64_t cumulated = 0;
+  for (std::size_t k = 0; k < nb_buckets; ++k) {
+    cumulated += this->buckets[p][k];
+    if ((cumulated > 0) && (cumulated >= rank)) {
+      // Lower bound of the unbounded bucket
+      return (k + 1 < nb_buckets) ?
+        tf2::metrics::bucket_bound(k) : tf2::metrics::bucket_bound(k - 1);
+    }
+  }
+  return tf2::metrics::bucket_bound(nb_buckets - 2);
+}
+
+// Prometheus exposition
+// ====================================
+void tf2::metrics::write_prometheus(
+  std::ostream& out,
+  const std::string& label
+) const {
+  const snapshot s = this->read();
+  const std::string model = "model=\"" + escape(label) + "\"";
+  // Counters
+  const std::vector<std::tuple<const char*, const char*, std::uint64_t>>
+  counters = {
+    {"tf2_calls_total", "Number of model calls.", s.nb_calls},
+    {"tf2_points_total", "Number of evaluated points.", s.nb_pts},
+    {"tf2_input_bytes_total", "Size of the caller's inputs.", s.bytes_in},
+    {"tf2_output_bytes_total", "Size of the caller's outputs.", s.bytes_out},
+    {
+      "tf2_zero_copy_inputs_total",
+      "Number of input tensors wrapping the caller's memory.",
+      s.zero_copy_inputs
+    },
+    {
+      "tf2_unaligned_inputs_total",
+      "Number of input tensors copied instead of wrapped, "
+      "the caller's memory not being aligned.",
+      s.unaligned_inputs
+    }
+  };
+  for (const auto &c : counters) {
+    out << "# HELP " << std::get<0>(c) << " " << std::get<1>(c) << "\n"
+        << "# TYPE " << std::get<0>(c) << " counter\n"
+        << std::get<0>(c) << "{" << model << "} " << std::get<2>(c) << "\n";
+  }
+  // Latency histograms
+  out << "# HELP tf2_phase_seconds Duration of the inference phases.\n"
+      << "# TYPE tf2_phase_seconds histogram\n";
+  const auto precision = out.precision(9);
+  for (std::size_t p = 0; p < nb_phases; ++p) {
+    const std::string labels = model + ",phase=\"" + phase_name(p) + "\"";
+    std::uint64_t cumulated = 0;
+    for (std::size_t k = 0; k < nb_buckets; ++k) {
+      cumulated += s.buckets[p][k];
+      out << "tf2_phase_seconds_bucket{" << labels << ",le=\"";
+      if (k + 1 < nb_buckets) {
+        out << bucket_bound(k);
+      } else {
+        out << "+Inf";
+      }
+      out << "\"} " << cumulated << "\n";
+    }
+    out << "tf2_phase_seconds_sum{" << labels << "} " << s.seconds[p] << "\n"
+        << "tf2_phase_seconds_count{" << labels << "} " << cumulated << "\n";
+  }
+  out.precision(precision);
+}
+
+// Periodic dump
+// ====================================
+void tf2::metrics::write_file(
+  const std::string& filename,
+  const std::string& label
+) {
+  const std::string tmp = filename + ".tmp";
+  {
+    std::ofstream file(tmp);
+    if (!file) {
+      return;
+    }
+    this->write_prometheus(file, label);
+  }
+  std::rename(tmp.c_str(), filename.c_str());
+}
+
+void tf2::metrics::start_dump(
+  const std::string& filename,
+  const double period,
+  const std::string& label
+) {
+  if (!(period > 0.0)) {
+    std::ostringstream message;
+    message << "\nFrom tf2::metrics::start_dump():"
+            << "\n> The dump period must be positive.";
+    throw std::invalid_argument(message.str());
+  }
+  this->stop_dump();
+  this->dump_stop = false;
+  this->dumper = std::thread([this, filename, period, label]() {
+    const auto interval = std::chrono::duration_cast<clock::duration>(
+      std::chrono::duration<double>(period)
+    );
+    std::unique_lock<std::mutex> guard(this->dump_lock);
+    while (!this->dump_wake.wait_for(
+      guard, interval, [this]() { return this->dump_stop; }
+    )) {
+      this->write_file(filename, label);
+    }
+    // Last dump, with the final values
+    this->write_file(filename, label);
+  });
+}
+
+void tf2::metrics::stop_dump() {
+  if (!this->dumper.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> guard(this->dump_lock);
+    this->dump_stop = true;
+  }
+  this->dump_wake.notify_one();
+  this->dumper.join();
+}
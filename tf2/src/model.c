@@ -1,31 +1,288 @@
 #include <fstream>
 #include <numeric>
+#include <chrono>
+#include <algorithm>
+#include <condition_variable>
 #include <nlohmann/json.hpp>
 #include <tensorflow/c/c_api.h>
 #include "model.h"
 
 using json = nlohmann::json;
 
+namespace {
+
+  // Deallocator for tensors wrapping memory owned by the caller
+  void noop_deallocator(void*, std::size_t, void*) {}
+
+  // Release the tensors of a signature
+  void release_tensors(std::vector<TF_Tensor*>& tensors) {
+    for (auto &t : tensors) {
+      TF_DeleteTensor(t);
+      t = nullptr;
+    }
+  }
+
+  // Tensor datatypes which can be converted from/to the caller's data
+  bool is_supported(const TF_DataType dtype) {
+    return (dtype == TF_FLOAT) || (dtype == TF_DOUBLE) ||
+      (dtype == TF_BFLOAT16);
+  }
+
+  // ConfigProto fields set from the JSON input file
+  enum config_field : std::uint32_t {
+    intra_op_parallelism_threads = 2,
+    inter_op_parallelism_threads = 5,
+    allow_soft_placement = 7,
+    use_per_session_threads = 9,
+    graph_options = 10
+  };
+
+  // GraphOptions, OptimizerOptions and RewriterConfig fields set
+  // by the optimization profiles
+  enum optimization_field : std::uint32_t {
+    // > GraphOptions
+    optimizer_options = 3,
+    rewrite_options = 10,
+    // > OptimizerOptions
+    opt_level = 3,
+    global_jit_level = 5,
+    cpu_global_jit = 7,
+    // > RewriterConfig
+    layout_optimizer = 1,
+    constant_folding = 3,
+    arithmetic_optimization = 7,
+    meta_optimizer_iterations = 12,
+    remapping = 14,
+    disable_meta_optimizer = 19
+  };
+
+  // RewriterConfig toggles
+  enum toggle : std::int8_t {
+    toggle_default = 0,
+    toggle_on = 1,
+    toggle_off = 2
+  };
+
+  // Graph optimizations of the session
+  struct optimization {
+    // Grappler passes
+    toggle constant_folding = toggle_default;
+    toggle arithmetic_optimization = toggle_default;
+    toggle layout_optimizer = toggle_default;
+    toggle remapping = toggle_default;
+    bool two_iterations = false;
+    bool disable_grappler = false;
+    // Classic graph optimizer (OptimizerOptions::L0)
+    bool disable_optimizer = false;
+    // XLA JIT compilation of the whole graph, on CPU too
+    bool xla_jit = false;
+  };
+
+  // Serialized GraphOptions of an `"optimization"` block, whose
+  // profile (with its overrides) is written to `name`
+  std::string make_graph_options(
+    const json& block,
+    std::string& name
+  ) {
+    optimization opt;
+    // Profile
+    name = block.value("profile", std::string("default"));
+    if ((name == "grappler") || (name == "xla")) {
+      opt.constant_folding = toggle_on;
+      opt.arithmetic_optimization = toggle_on;
+      opt.layout_optimizer = toggle_on;
+      opt.remapping = toggle_on;
+      opt.two_iterations = true;
+      opt.xla_jit = (name == "xla");
+    } else if (name == "none") {
+      opt.disable_grappler = true;
+      opt.disable_optimizer = true;
+    } else if (name != "default") {
+      std::ostringstream message;
+      message << "\nFrom tf2::model::parse_inputs():"
+              << "\n> 'optimization.profile' must be \"default\","
+              << " \"none\", \"grappler\" or \"xla\".";
+      throw std::invalid_argument(message.str());
+    }
+    // Overrides
+    const std::vector<std::pair<std::string, toggle*>> passes = {
+      {"constant_folding", &opt.constant_folding},
+      {"arithmetic_optimization", &opt.arithmetic_optimization},
+      {"layout_optimizer", &opt.layout_optimizer},
+      {"remapping", &opt.remapping}
+    };
+    for (const auto &pass : passes) {
+      if (block.contains(pass.first)) {
+        const bool on = block[pass.first].get<bool>();
+        *pass.second = on ? toggle_on : toggle_off;
+        name += "," + pass.first + (on ? "=on" : "=off");
+      }
+    }
+    if (block.contains("xla_jit")) {
+      opt.xla_jit = block["xla_jit"].get<bool>();
+      name += std::string(",xla_jit") + (opt.xla_jit ? "=on" : "=off");
+    }
+    // RewriterConfig
+    std::string rewriter;
+    const std::vector<std::pair<std::uint32_t, toggle>> toggles = {
+      {layout_optimizer, opt.layout_optimizer},
+      {constant_folding, opt.constant_folding},
+      {arithmetic_optimization, opt.arithmetic_optimization},
+      {remapping, opt.remapping}
+    };
+    for (const auto &t : toggles) {
+      if (t.second != toggle_default) {
+        tf2::proto::write_int(rewriter, t.first, t.second);
+      }
+    }
+    if (opt.two_iterations) {
+      tf2::proto::write_int(rewriter, meta_optimizer_iterations, 2);
+    }
+    if (opt.disable_grappler) {
+      tf2::proto::write_int(rewriter, disable_meta_optimizer, true);
+    }
+    // OptimizerOptions
+    std::string optimizer;
+    if (opt.disable_optimizer) {
+      tf2::proto::write_int(optimizer, opt_level, -1);
+    }
+    if (opt.xla_jit) {
+      tf2::proto::write_int(optimizer, global_jit_level, 1);
+      tf2::proto::write_int(optimizer, cpu_global_jit, true);
+    }
+    // GraphOptions
+    std::string options;
+    if (!optimizer.empty()) {
+      tf2::proto::write_bytes(options, optimizer_options, optimizer);
+    }
+    if (!rewriter.empty()) {
+      tf2::proto::write_bytes(options, rewrite_options, rewriter);
+    }
+    return options;
+  }
+
+  // Serialized ConfigProto of the session: the raw `config`, merged
+  // with the readable keys (later fields override earlier ones)
+  std::string make_session_config(
+    const json& inputs,
+    const std::string& config
+  ) {
+    std::string proto = config;
+    if (inputs.contains("intra_op_threads")) {
+      tf2::proto::write_int(
+        proto, intra_op_parallelism_threads,
+        inputs["intra_op_threads"].get<std::int32_t>()
+      );
+    }
+    if (inputs.contains("inter_op_threads")) {
+      tf2::proto::write_int(
+        proto, inter_op_parallelism_threads,
+        inputs["inter_op_threads"].get<std::int32_t>()
+      );
+    }
+    if (inputs.contains("allow_soft_placement")) {
+      tf2::proto::write_int(
+        proto, allow_soft_placement,
+        inputs["allow_soft_placement"].get<bool>()
+      );
+    }
+    if (inputs.contains("use_per_session_threads")) {
+      tf2::proto::write_int(
+        proto, use_per_session_threads,
+        inputs["use_per_session_threads"].get<bool>()
+      );
+    }
+    return proto;
+  }
+
+  // Call `f` with a null pointer to the element type of a datatype
+  template <typename F>
+  void visit_dtype(
+    const TF_DataType dtype,
+    F&& f
+  ) {
+    switch (dtype) {
+      case TF_FLOAT:
+        f(static_cast<float*>(nullptr));
+        break;
+      case TF_DOUBLE:
+        f(static_cast<double*>(nullptr));
+        break;
+      case TF_BFLOAT16:
+        f(static_cast<tf2::kernels::bfloat16*>(nullptr));
+        break;
+      default:
+        throw std::invalid_argument(
+          "Unsupported datatype: " + cppflow::to_string(dtype)
+        );
+    }
+  }
+
+} // namespace
+
 
 // Constructor
 // ====================================
 // Main function
 // ------------------------------------
 tf2::model::model(
-  const std::string inpfile
+  const std::string inpfile,
+  const tf2::backend backend
 ) {
+  // Time each loading phase
+  auto start = std::chrono::steady_clock::now();
+  auto phase = [this, &start](const std::string& name) {
+    const auto stop = std::chrono::steady_clock::now();
+    this->load_times.emplace_back(
+      name, std::chrono::duration<double>(stop - start).count()
+    );
+    start = stop;
+  };
   // Parse inputs from json file
-  this->parse_inputs(inpfile);
+  const bool hosted = (backend == tf2::backend::hosted);
+  this->parse_inputs(inpfile, hosted);
+  if (!this->metrics_file.empty()) {
+    this->stats.start_dump(
+      this->metrics_file, this->metrics_period, this->path_to_model
+    );
+  }
+  phase("parse_inputs");
+  if (backend != tf2::backend::inpfile) {
+    this->mode = hosted ? tf2::backend::local : backend;
+  }
+  // Open the model on the tf2d daemon
+  if (this->mode == tf2::backend::daemon) {
+    this->remote = std::unique_ptr<tf2::client>(
+      new tf2::client(this->daemon_socket, inpfile)
+    );
+    this->inputs_dim = this->remote->inputs_dim;
+    this->outputs_dim = this->remote->outputs_dim;
+    this->inp_tot_dim = std::accumulate(
+      this->inputs_dim.begin(), this->inputs_dim.end(), 0
+    );
+    this->out_tot_dim = std::accumulate(
+      this->outputs_dim.begin(), this->outputs_dim.end(), 0
+    );
+    this->ws = std::unique_ptr<tf2::workspace>(new tf2::workspace());
+    phase("connect");
+    return;
+  }
   // Set global TF context
-  if (this->config != nullptr) {
-    this->set_global_context(*this->config);
+  if (!this->config.empty()) {
+    this->set_global_context(this->config);
   }
-  // Initialize TensorFlow model
-  this->tfmodel = std::unique_ptr<cppflow::model>(
-    new cppflow::model(this->path_to_model)
-  );
-  // Get input/output operations
-  this->get_ops_info();
+  phase("context");
+  // Initialize TensorFlow model, or share the loaded one
+  if (this->share_session) {
+    this->tfmodel = tf2::registry::acquire(
+      this->path_to_model, this->session_config, this->format
+    );
+  } else {
+    this->tfmodel = std::make_shared<cppflow::model>(
+      this->path_to_model, this->format, this->session_config
+    );
+  }
+  phase("load");
   // Check inputs/outputs operations
   this->inputs_dim = this->check_io_ops(this->inputs_id);
   this->outputs_dim = this->check_io_ops(this->outputs_id);
@@ -36,30 +293,79 @@ tf2::model::model(
   this->out_tot_dim = std::accumulate(
     this->outputs_dim.begin(), this->outputs_dim.end(), 0
   );
-  // Check if batched inference is allowed
-  if (this->batch_size > 0) {
-    bool c1 = (this->inputs_dim.size() > 1);
-    bool c2 = (this->outputs_dim.size() > 1);
-    if (c1 || c2) {
-      std::ostringstream message;
-      message << "\nFrom tf2::model::model():"
-              << "\n> Multi-input-multi-output models are "
-              << "currently not supported for batched inference.";
-      throw std::runtime_error(message.str());
+  phase("check_io");
+  // Resolve input/output endpoints once
+  this->transpose_in_graph = this->transpose_in_graph && !this->rowmajor;
+  if (this->transpose_in_graph) {
+    // Bind to column-major endpoints appended to the graph
+    const tf2::graph::endpoints io = tf2::graph::transpose_io(
+      this->tfmodel->get_graph(),
+      this->inputs_id,
+      this->outputs_id,
+      this->inputs_dim
+    );
+    this->sigs.emplace_back(
+      this->tfmodel->get_graph(), io.inputs_id, io.outputs_id
+    );
+  } else {
+    this->sigs.emplace_back(
+      this->tfmodel->get_graph(), this->inputs_id, this->outputs_id
+    );
+  }
+  this->status.emplace_back(TF_NewStatus(), &TF_DeleteStatus);
+  // Detect inputs/outputs datatypes
+  this->inputs_dtype = this->check_io_dtypes(
+    this->inputs_id, this->sigs[0].inputs
+  );
+  this->outputs_dtype = this->check_io_dtypes(
+    this->outputs_id, this->sigs[0].outputs
+  );
+  phase("signatures");
+  // Initialize persistent workspace
+  this->ws = std::unique_ptr<tf2::workspace>(new tf2::workspace());
+  // Initialize the batches pool and pipeline
+  this->set_max_concurrent_batches(this->max_concurrent_batches);
+  this->set_pipeline_depth(this->pipeline_depth);
+  phase("workspace");
+  // Select the batch size
+  if (this->auto_batch_size) {
+    this->calibrate_batch_size();
+    phase("calibration");
+  }
+  // Warm up the session
+  if (this->warmup_runs > 0) {
+    if (this->warmup_background) {
+      std::lock_guard<std::mutex> guard(this->async_lock);
+      this->exec = std::unique_ptr<tf2::executor>(new tf2::executor());
+      this->warmup_done = this->exec->submit([this]() { this->warmup(); });
+    } else {
+      this->warmup();
+      phase("warmup");
     }
   }
 }
 
+// Destructor
+// ------------------------------------
+tf2::model::~model() {
+  // Run the pending asynchronous calls before releasing the model
+  this->exec.reset();
+  // Write the final metrics
+  this->stats.stop_dump();
+}
+
 // Util functions
 // ------------------------------------
 void tf2::model::parse_inputs(
-  const std::string inpfile
+  const std::string inpfile,
+  const bool hosted
 ) {
   // Initialize JSON object reader
   std::ifstream file(inpfile);
   json inputs = json::parse(file);
-  // Environmental variables
-  if (inputs.contains("env")) {
+  // Environmental variables (left to the clients of the models hosted
+  // by the tf2d daemon, where `setenv` would race with other threads)
+  if (inputs.contains("env") && !hosted) {
     for (const auto& item : inputs["env"].items()) {
       const std::string k = item.key();
       const std::string v = item.value();
@@ -70,36 +376,312 @@ void tf2::model::parse_inputs(
   this->path_to_model = inputs["path_to_model"];
   this->inputs_id = inputs["inputs_id"];
   this->outputs_id = inputs["outputs_id"];
+  this->share_session = inputs.value("share_session", this->share_session);
+  // Model format
+  if (inputs.contains("model_format")) {
+    const std::string name = inputs["model_format"];
+    if (name == "frozen_graph") {
+      this->format = cppflow::model::TYPE::FROZEN_GRAPH;
+    } else if (name != "saved_model") {
+      std::ostringstream message;
+      message << "\nFrom tf2::model::parse_inputs():"
+              << "\n> 'model_format' must be \"saved_model\" or"
+              << " \"frozen_graph\".";
+      throw std::invalid_argument(message.str());
+    }
+  }
+  // Backend
+  if (inputs.contains("backend")) {
+    const std::string name = inputs["backend"];
+    if (name == "daemon") {
+      this->mode = tf2::backend::daemon;
+    } else if (name != "local") {
+      std::ostringstream message;
+      message << "\nFrom tf2::model::parse_inputs():"
+              << "\n> 'backend' must be \"local\" or \"daemon\".";
+      throw std::invalid_argument(message.str());
+    }
+  }
+  this->daemon_socket = inputs.value("daemon_socket", this->daemon_socket);
   this->rowmajor = inputs.value("rowmajor", this->rowmajor);
-  this->batch_size = inputs.value("batch_size", this->batch_size);
+  this->transpose_in_graph = inputs.value(
+    "transpose_in_graph", this->transpose_in_graph
+  );
+  if (inputs.contains("batch_size") && inputs["batch_size"].is_string()) {
+    if (inputs["batch_size"] != "auto") {
+      std::ostringstream message;
+      message << "\nFrom tf2::model::parse_inputs():"
+              << "\n> 'batch_size' must be an integer or \"auto\".";
+      throw std::invalid_argument(message.str());
+    }
+    this->auto_batch_size = true;
+  } else {
+    this->batch_size = inputs.value("batch_size", this->batch_size);
+  }
+  if (inputs.contains("batch_size_tuning")) {
+    const json& tuning = inputs["batch_size_tuning"];
+    this->max_batch_size = tuning.value(
+      "max_batch_size", this->max_batch_size
+    );
+    this->max_batch_memory_mb = tuning.value(
+      "max_memory_mb", this->max_batch_memory_mb
+    );
+    this->adaptive_batch_size = tuning.value(
+      "adaptive", this->adaptive_batch_size
+    );
+  }
+  this->adaptive_batch_size = this->adaptive_batch_size &&
+    this->auto_batch_size;
+  this->zero_copy = inputs.value("zero_copy", this->zero_copy);
+  this->max_concurrent_batches = inputs.value(
+    "max_concurrent_batches", this->max_concurrent_batches
+  );
+  this->pipeline_depth = inputs.value(
+    "pipeline_depth", this->pipeline_depth
+  );
+  // Sampled profiling
+  if (inputs.contains("profiling")) {
+    const json& profiling = inputs["profiling"];
+    const std::string level = profiling.value(
+      "trace_level", std::string("software")
+    );
+    tf2::profiler::level trace_level;
+    if (level == "software") {
+      trace_level = tf2::profiler::software;
+    } else if (level == "hardware") {
+      trace_level = tf2::profiler::hardware;
+    } else if (level == "full") {
+      trace_level = tf2::profiler::full;
+    } else {
+      std::ostringstream message;
+      message << "\nFrom tf2::model::parse_inputs():"
+              << "\n> 'profiling.trace_level' must be \"software\","
+              << " \"hardware\" or \"full\".";
+      throw std::invalid_argument(message.str());
+    }
+    this->prof = std::unique_ptr<tf2::profiler>(
+      new tf2::profiler(profiling.value("period", 100), trace_level)
+    );
+  }
+  // Periodic dump of the metrics
+  if (inputs.contains("metrics")) {
+    const json& metrics = inputs["metrics"];
+    if (!hosted) {
+      this->metrics_file = metrics.value("file", this->metrics_file);
+    }
+    this->metrics_period = metrics.value("period_s", this->metrics_period);
+  }
+  // Warm-up runs
+  if (inputs.contains("warmup")) {
+    const json& warmup = inputs["warmup"];
+    this->warmup_runs = warmup.value("runs", 1);
+    this->warmup_nb_pts = warmup.value("nb_pts", this->warmup_nb_pts);
+    this->warmup_background = warmup.value(
+      "background", this->warmup_background
+    );
+    if (this->warmup_runs < 0) {
+      std::ostringstream message;
+      message << "\nFrom tf2::model::parse_inputs():"
+              << "\n> 'warmup.runs' must be non-negative.";
+      throw std::invalid_argument(message.str());
+    }
+    for (const std::int32_t n : this->warmup_nb_pts) {
+      if (n < 1) {
+        std::ostringstream message;
+        message << "\nFrom tf2::model::parse_inputs():"
+                << "\n> 'warmup.nb_pts' must be positive.";
+        throw std::invalid_argument(message.str());
+      }
+    }
+  }
+  // Raw ConfigProto, given as a list of hexadecimal bytes
   if (inputs.contains("config")) {
-    std::vector<std::string> cfg = inputs["config"];
-    this->config = &cfg;
+    for (const std::string byte : inputs["config"]) {
+      this->config.push_back(
+        static_cast<char>(std::stoul(byte, nullptr, 16))
+      );
+    }
+  }
+  // Session threading and placement
+  this->session_config = make_session_config(inputs, this->config);
+  // Graph optimizations
+  if (inputs.contains("optimization")) {
+    const std::string options = make_graph_options(
+      inputs["optimization"], this->optimization_profile
+    );
+    if (!options.empty()) {
+      tf2::proto::write_bytes(this->session_config, graph_options, options);
+    }
   }
 };
 
 void tf2::model::set_global_context(
-  const std::vector<std::string>& config
+  const std::string& config
 ) {
   // Create new options with the new configuration
-  TFE_ContextOptions *opts = TFE_NewContextOptions();
+  std::unique_ptr<TFE_ContextOptions, decltype(&TFE_DeleteContextOptions)>
+    opts(TFE_NewContextOptions(), &TFE_DeleteContextOptions);
   TFE_ContextOptionsSetConfig(
-    opts, config.data(), config.size(), cppflow::context::get_status()
+    opts.get(), config.data(), config.size(), cppflow::context::get_status()
   );
+  cppflow::status_check(cppflow::context::get_status());
   // Replace the global context with user options
-  cppflow::get_global_context() = cppflow::context(opts);
+  cppflow::get_global_context() = cppflow::context(opts.get());
 };
 
-void tf2::model::get_ops_info() {
-  // Get operations identifiers
-  std::vector<std::string> ops_id = this->tfmodel->get_operations();
-  // Store identifier-shape pairs
-  for (const auto &op_id : ops_id) {
-    bool c1 = (op_id.rfind(this->inputs_id_prefix, 0) == 0);
-    bool c2 = (op_id.rfind(this->outputs_id_prefix, 0) == 0);
-    if (c1 || c2) {
-      auto shape = this->tfmodel->get_operation_shape(op_id);
-      this->ops.emplace_back(op_id, shape);
+void tf2::model::set_max_concurrent_batches(
+  const std::int32_t n
+) {
+  if (n < 1) {
+    std::ostringstream message;
+    message << "\nFrom tf2::model::set_max_concurrent_batches():"
+            << "\n> The number of concurrent batches must be positive.";
+    throw std::invalid_argument(message.str());
+  }
+  std::lock_guard<std::mutex> guard(this->call_lock);
+  this->max_concurrent_batches = n;
+  this->resize_slots();
+  // Start the threads pool
+  this->pool.reset();
+  if (n > 1) {
+    this->pool = std::unique_ptr<tf2::thread_pool>(new tf2::thread_pool(n));
+  }
+}
+
+void tf2::model::set_pipeline_depth(
+  const std::int32_t n
+) {
+  if (n < 1) {
+    std::ostringstream message;
+    message << "\nFrom tf2::model::set_pipeline_depth():"
+            << "\n> The pipeline depth must be positive.";
+    throw std::invalid_argument(message.str());
+  }
+  std::lock_guard<std::mutex> guard(this->call_lock);
+  this->pipeline_depth = n;
+  this->resize_slots();
+  // Start the pipeline stages threads (producer, runner and consumer)
+  this->pipe.reset();
+  if (n > 1) {
+    this->pipe = std::unique_ptr<tf2::thread_pool>(new tf2::thread_pool(3));
+  }
+}
+
+void tf2::model::set_batch_size(
+  const std::int32_t n
+) {
+  std::lock_guard<std::mutex> guard(this->call_lock);
+  this->batch_size = n;
+  this->adaptive_batch_size = false;
+}
+
+std::vector<tf2::batch_tuner::point> tf2::model::get_batch_size_curve() {
+  std::lock_guard<std::mutex> guard(this->call_lock);
+  return this->tuner.curve();
+}
+
+void tf2::model::calibrate_batch_size() {
+  // Batches per timed call (so that concurrent or pipelined
+  // batches are accounted for, as in the actual calls)
+  const std::int32_t nb_batches = 4;
+  const std::size_t nb_reps = 3;
+  // Size of the input/output tensors of a point,
+  // for all the batches in flight
+  std::size_t bytes = 0;
+  for (std::size_t i = 0; i < this->inputs_dim.size(); ++i) {
+    bytes += TF_DataTypeSize(this->inputs_dtype[i]) * this->inputs_dim[i];
+  }
+  for (std::size_t i = 0; i < this->outputs_dim.size(); ++i) {
+    bytes += TF_DataTypeSize(this->outputs_dtype[i]) * this->outputs_dim[i];
+  }
+  bytes *= this->sigs.size();
+  std::int64_t max_size = std::min(
+    this->max_batch_size, std::numeric_limits<std::int32_t>::max() / nb_batches
+  );
+  if (this->max_batch_memory_mb > 0.0) {
+    max_size = std::min(
+      max_size,
+      static_cast<std::int64_t>(this->max_batch_memory_mb * (1 << 20) / bytes)
+    );
+  }
+  const std::vector<std::int32_t> sizes = tf2::batch_tuner::candidates(
+    static_cast<std::int32_t>(max_size)
+  );
+  if (sizes.empty()) {
+    std::ostringstream message;
+    message << "\nFrom tf2::model::calibrate_batch_size():"
+            << "\n> The memory cap does not allow any batch size.";
+    throw std::invalid_argument(message.str());
+  }
+  // Sweep the batch sizes on synthetic inputs, until the throughput
+  // stops improving
+  const bool adaptive = this->adaptive_batch_size;
+  this->adaptive_batch_size = false;
+  std::vector<float> x, y;
+  std::int32_t nb_stalls = 0;
+  for (const std::int32_t b : sizes) {
+    const std::int32_t nb_pts = nb_batches * b;
+    x.resize(static_cast<std::size_t>(nb_pts) * this->inp_tot_dim, 0.0f);
+    y.resize(static_cast<std::size_t>(nb_pts) * this->out_tot_dim);
+    this->batch_size = b;
+    // > Warm-up
+    this->run_batches<float>(x.data(), y.data(), nb_pts);
+    // > Best time over a few calls
+    double seconds = std::numeric_limits<double>::max();
+    for (std::size_t r = 0; r < nb_reps; ++r) {
+      const auto t0 = std::chrono::steady_clock::now();
+      this->run_batches<float>(x.data(), y.data(), nb_pts);
+      const std::chrono::duration<double> dt =
+        std::chrono::steady_clock::now() - t0;
+      seconds = std::min(seconds, dt.count());
+    }
+    const std::int32_t best = this->tuner.best();
+    this->tuner.record(b, nb_pts, seconds);
+    nb_stalls = (this->tuner.best() == best) ? nb_stalls + 1 : 0;
+    if (nb_stalls == 2) {
+      break;
+    }
+  }
+  this->adaptive_batch_size = adaptive;
+  this->batch_size = this->tuner.best();
+  // Release the calibration tensors
+  this->ws->trim();
+}
+
+void tf2::model::warmup() {
+  const auto t0 = std::chrono::steady_clock::now();
+  // Shapes to run (by default, one batch)
+  std::vector<std::int32_t> shapes = this->warmup_nb_pts;
+  if (shapes.empty()) {
+    shapes.push_back(std::max(this->batch_size, 1));
+  }
+  // Run the model on synthetic inputs, as the actual calls do
+  std::vector<float> x, y;
+  for (const std::int32_t nb_pts : shapes) {
+    x.assign(static_cast<std::size_t>(nb_pts) * this->inp_tot_dim, 0.0f);
+    y.resize(static_cast<std::size_t>(nb_pts) * this->out_tot_dim);
+    for (std::int32_t r = 0; r < this->warmup_runs; ++r) {
+      this->call<float>(x.data(), y.data(), nb_pts);
+    }
+  }
+  const std::chrono::duration<double> dt =
+    std::chrono::steady_clock::now() - t0;
+  this->warmup_time = dt.count();
+}
+
+void tf2::model::resize_slots() {
+  if (this->sigs.empty()) {
+    return;
+  }
+  // One signature and status per thread or buffer set
+  const std::size_t n = static_cast<std::size_t>(
+    std::max(this->max_concurrent_batches, this->pipeline_depth)
+  );
+  this->sigs.resize(n, this->sigs[0]);
+  this->status.resize(n);
+  for (auto &s : this->status) {
+    if (!s) {
+      s = {TF_NewStatus(), &TF_DeleteStatus};
     }
   }
 }
@@ -107,157 +689,567 @@ void tf2::model::get_ops_info() {
 std::vector<std::int32_t> tf2::model::check_io_ops(
   const std::vector<std::string> identifiers
 ) {
-  std::vector<std::int64_t> dim;
+  TF_Graph* graph = this->tfmodel->get_graph();
+  std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(
+    TF_NewStatus(), &TF_DeleteStatus
+  );
+  std::vector<std::int32_t> dim;
   for (const auto &i_id : identifiers) {
-    bool found = false;
-    for (const auto &op : this->ops) {
-      const std::string op_id = std::get<0>(op);
-      if (i_id.find(op_id) != std::string::npos) {
-        for (auto i = 0; i < this->max_nb_io; ++i) {
-          if (i_id == op_id + ":" + std::to_string(i)) {
-            dim.push_back(std::get<1>(op)[1]);
-            found = true;
-            break;
-          }
-        }
-      }
-      if (found) break;
-    }
-    if (!found) {
+    // Resolve the identifier directly, instead of scanning the graph
+    const auto [op_name, op_idx] = cppflow::parse_name(i_id);
+    TF_Output endpoint;
+    endpoint.oper = TF_GraphOperationByName(graph, op_name.c_str());
+    endpoint.index = op_idx;
+    if (
+      (endpoint.oper == nullptr) ||
+      (op_idx < 0) ||
+      (op_idx >= TF_OperationNumOutputs(endpoint.oper))
+    ) {
       std::ostringstream message;
       message << "\nFrom tf2::model::check_io_ops():"
               << "\n> Operation identifier '" << i_id << "' not found!"
               << "\n> Available options are:";
-      for (const auto &op : this->ops) {
-        message << "\n> - " << std::get<0>(op) << ":<i>";
+      std::size_t pos = 0;
+      while (TF_Operation* op = TF_GraphNextOperation(graph, &pos)) {
+        const std::string op_id = TF_OperationName(op);
+        bool c1 = (op_id.rfind(this->inputs_id_prefix, 0) == 0);
+        bool c2 = (op_id.rfind(this->outputs_id_prefix, 0) == 0);
+        if (c1 || c2) {
+          message << "\n> - " << op_id << ":<i>";
+        }
       }
       throw std::runtime_error(message.str());
     }
+    // Shape of this very output ([nb_pts, dim])
+    const int nb_dims = TF_GraphGetTensorNumDims(
+      graph, endpoint, status.get()
+    );
+    cppflow::status_check(status.get());
+    if (nb_dims < 2) {
+      std::ostringstream message;
+      message << "\nFrom tf2::model::check_io_ops():"
+              << "\n> Operation identifier '" << i_id << "' has no"
+              << " [nb_pts, dim] shape!";
+      throw std::runtime_error(message.str());
+    }
+    std::vector<std::int64_t> shape(nb_dims);
+    TF_GraphGetTensorShape(
+      graph, endpoint, shape.data(), nb_dims, status.get()
+    );
+    cppflow::status_check(status.get());
+    dim.push_back(static_cast<std::int32_t>(shape[1]));
   }
-  // Recast
-  std::vector<std::int32_t> _dim(dim.begin(), dim.end());
-  return _dim;
+  return dim;
 };
 
+std::vector<TF_DataType> tf2::model::check_io_dtypes(
+  const std::vector<std::string>& identifiers,
+  const std::vector<TF_Output>& endpoints
+) {
+  std::vector<TF_DataType> dtypes;
+  for (std::size_t i = 0; i < endpoints.size(); ++i) {
+    const TF_DataType dtype = TF_OperationOutputType(endpoints[i]);
+    if (!is_supported(dtype)) {
+      std::ostringstream message;
+      message << "\nFrom tf2::model::check_io_dtypes():"
+              << "\n> Unsupported datatype (" << cppflow::to_string(dtype)
+              << ") of operation '" << identifiers[i] << "'."
+              << "\n> Supported datatypes are float32, float64 and bfloat16.";
+      throw std::runtime_error(message.str());
+    }
+    dtypes.push_back(dtype);
+  }
+  return dtypes;
+}
+
 // Inputs/Outputs manipulations
 // ====================================
 template <typename T>
-tf2::data::list_tuple_tensor tf2::model::compose_inputs(
-  const std::vector<T>& inputs,
-  const std::int32_t nb_pts
+void tf2::model::compose_inputs(
+  const T* inputs,
+  const std::int32_t nb_pts,
+  const std::int32_t start,
+  const std::int32_t size,
+  TF_Tensor** tf_inputs
 ) {
   // Get the number of inputs (single-/multi-inputs)
   const std::size_t nb_inp = this->inputs_dim.size();
-  tf2::data::list_tuple_tensor x;
   // Loop over inputs
-  std::int32_t delta, start = 0;
+  std::size_t offset = 0;
   for (std::size_t i = 0; i < nb_inp; ++i) {
-    // > Extract i-th input
-    delta = this->inputs_dim[i] * nb_pts;
-    std::vector<T> xi(inputs.begin() + start, inputs.begin() + start + delta);
-    // > If column-major, reorder the input
-    if (!this->rowmajor) {
-      tf2::ops::invert_major<T>(xi, this->inputs_dim[i], nb_pts, true);
+    // > Locate the batch in the i-th input block
+    const std::int32_t dim = this->inputs_dim[i];
+    const std::size_t delta = static_cast<std::size_t>(dim) * size;
+    T* xi = const_cast<T*>(inputs + offset);
+    if (this->rowmajor) {
+      xi += static_cast<std::size_t>(start) * dim;
+    } else {
+      xi += start;
     }
-    // Convert std::vector to cppflow::tensor with the proper shape
-    cppflow::tensor xi_tf(xi, {nb_pts, this->inputs_dim[i]});
-    // Move cppflow::tensor to GPU if CUDA available
-    auto on_gpu = xi_tf.device(true).find("GPU");
-    if ((this->tfmodel->is_cuda_available) && (on_gpu != std::string::npos)) {
-      xi_tf = cppflow::bitcast(xi_tf, xi_tf.dtype());
+    // > Column-major batches are fed as [dim, size] when the graph
+    //   transposes them, and as [size, dim] otherwise
+    const bool in_graph = this->transpose_in_graph;
+    const std::int64_t shape[2] = {
+      in_graph ? dim : size, in_graph ? size : dim
+    };
+    // > Contiguous batches: row-major data, column-major data with a
+    //   single feature, or with a single point (whole data if in-graph)
+    const bool contiguous = this->rowmajor || dim == 1 ||
+      (in_graph ? size == nb_pts : nb_pts == 1);
+    const TF_DataType dtype = this->inputs_dtype[i];
+    if (contiguous && this->zero_copy &&
+        dtype == cppflow::deduce_tf_type<T>()) {
+      // Wrap the caller's memory (no copy), unless TensorFlow would
+      // copy it anyway because it is not aligned
+      const bool aligned = (
+        reinterpret_cast<std::uintptr_t>(xi) % tf2::workspace::alignment
+      ) == 0;
+      this->stats.add_zero_copy(aligned);
+      if (aligned) {
+        tf_inputs[i] = TF_NewTensor(
+          dtype, shape, 2, xi, delta * sizeof(T), &noop_deallocator, nullptr
+        );
+        offset += static_cast<std::size_t>(dim) * nb_pts;
+        continue;
+      }
     }
-    // Make and append the tuple for i-th input
-    x.emplace_back(this->inputs_id[i], std::move(xi_tf));
-    // > Update the counter
-    start += delta;
+    // > Write the i-th input straight into a pooled tensor, converting
+    //   it to the input datatype on the fly (one copy)
+    tf_inputs[i] = this->ws->new_tensor(dtype, shape, 2);
+    visit_dtype(dtype, [&](auto* tag) {
+      using U = std::remove_pointer_t<decltype(tag)>;
+      U* data = static_cast<U*>(TF_TensorData(tf_inputs[i]));
+      if (contiguous) {
+        tf2::kernels::convert<T, U>(xi, data, delta);
+      } else if (in_graph) {
+        // Copy the strided column slices of the batch
+        tf2::kernels::copy_rows<T, U>(xi, data, dim, size, nb_pts, size);
+      } else {
+        // Gather the strided column slices of the batch
+        // (on this thread, the batches run concurrently on the pool)
+        tf2::kernels::transpose<T, U>(xi, data, dim, size, nb_pts, dim, 1);
+      }
+    });
+    // > Move to the next input block
+    offset += static_cast<std::size_t>(dim) * nb_pts;
   }
-  return x;
 }
 
 template <typename T>
 void tf2::model::compose_outputs(
-  std::vector<T>& outputs,
-  const std::vector<cppflow::tensor>& tf_outputs,
-  const std::int32_t nb_pts
+  T* outputs,
+  TF_Tensor* const* tf_outputs,
+  const std::int32_t nb_pts,
+  const std::int32_t start,
+  const std::int32_t size
 ) {
   // Get the number of outputs (single-/multi-outputs)
   const std::size_t nb_out = this->outputs_dim.size();
   // Loop over outputs
-  std::size_t index = 0;
+  std::size_t offset = 0;
   for (std::size_t i = 0; i < nb_out; ++i) {
-    // Extract data from i-th output (row-major ordering)
-    std::vector<T> yi = tf_outputs[i].get_data<T>();
-    // > If column-major, reorder the input
-    if (!this->rowmajor) {
-      tf2::ops::invert_major<T>(yi, nb_pts, this->outputs_dim[i], false);
+    // Check the i-th output against the caller's array
+    const std::int32_t dim = this->outputs_dim[i];
+    const std::size_t delta = static_cast<std::size_t>(dim) * size;
+    const TF_Tensor* yi_tf = tf_outputs[i];
+    this->check_output(i, yi_tf, size);
+    // Locate the batch in the i-th output block
+    T* yi = outputs + offset;
+    if (this->rowmajor) {
+      yi += static_cast<std::size_t>(start) * dim;
+    } else {
+      yi += start;
     }
-    // Move to outputs
-    std::move(yi.begin(), yi.end(), outputs.begin() + index);
-    index += yi.size();
+    // Read the i-th output once, straight into the caller's array,
+    // converting it and reordering it if column-major
+    const bool in_graph = this->transpose_in_graph;
+    const bool contiguous = this->rowmajor || dim == 1 ||
+      (in_graph ? size == nb_pts : nb_pts == 1);
+    visit_dtype(TF_TensorType(yi_tf), [&](auto* tag) {
+      using U = std::remove_pointer_t<decltype(tag)>;
+      const U* data = static_cast<const U*>(TF_TensorData(yi_tf));
+      if (contiguous) {
+        tf2::kernels::convert<U, T>(data, yi, delta);
+      } else if (in_graph) {
+        // Copy the batch into the strided column slices
+        tf2::kernels::copy_rows<U, T>(data, yi, dim, size, size, nb_pts);
+      } else {
+        // Scatter the batch into the strided column slices
+        tf2::kernels::transpose<U, T>(data, yi, size, dim, dim, nb_pts, 1);
+      }
+    });
+    // Move to the next output block
+    offset += static_cast<std::size_t>(dim) * nb_pts;
+  }
+}
+
+template <typename T>
+void tf2::model::compose_inputs(
+  const T* const* rows,
+  const std::int32_t,
+  const std::int32_t start,
+  const std::int32_t size,
+  TF_Tensor** tf_inputs
+) {
+  // Get the number of inputs (single-/multi-inputs)
+  const std::size_t nb_inp = this->inputs_dim.size();
+  // Loop over inputs
+  std::size_t offset = 0;
+  for (std::size_t i = 0; i < nb_inp; ++i) {
+    // Gather the i-th input of each point of the batch straight
+    // into a pooled tensor, converting it on the fly (one copy)
+    const std::int32_t dim = this->inputs_dim[i];
+    const bool in_graph = this->transpose_in_graph;
+    const std::int64_t shape[2] = {
+      in_graph ? dim : size, in_graph ? size : dim
+    };
+    const TF_DataType dtype = this->inputs_dtype[i];
+    tf_inputs[i] = this->ws->new_tensor(dtype, shape, 2);
+    visit_dtype(dtype, [&](auto* tag) {
+      using U = std::remove_pointer_t<decltype(tag)>;
+      U* data = static_cast<U*>(TF_TensorData(tf_inputs[i]));
+      for (std::int32_t p = 0; p < size; ++p) {
+        const T* xi = rows[start + p] + offset;
+        if (in_graph) {
+          tf2::kernels::copy_rows<T, U>(xi, data + p, dim, 1, 1, size);
+        } else {
+          tf2::kernels::convert<T, U>(
+            xi, data + static_cast<std::size_t>(p) * dim, dim
+          );
+        }
+      }
+    });
+    // Move to the next input
+    offset += dim;
+  }
+}
+
+template <typename T>
+void tf2::model::compose_outputs(
+  T* const* rows,
+  TF_Tensor* const* tf_outputs,
+  const std::int32_t,
+  const std::int32_t start,
+  const std::int32_t size
+) {
+  // Get the number of outputs (single-/multi-outputs)
+  const std::size_t nb_out = this->outputs_dim.size();
+  // Loop over outputs
+  std::size_t offset = 0;
+  for (std::size_t i = 0; i < nb_out; ++i) {
+    // Check the i-th output against the caller's array
+    const std::int32_t dim = this->outputs_dim[i];
+    const TF_Tensor* yi_tf = tf_outputs[i];
+    this->check_output(i, yi_tf, size);
+    // Scatter the i-th output straight into the rows of the batch
+    visit_dtype(TF_TensorType(yi_tf), [&](auto* tag) {
+      using U = std::remove_pointer_t<decltype(tag)>;
+      const U* data = static_cast<const U*>(TF_TensorData(yi_tf));
+      for (std::int32_t p = 0; p < size; ++p) {
+        T* yi = rows[start + p] + offset;
+        if (this->transpose_in_graph) {
+          tf2::kernels::copy_rows<U, T>(data + p, yi, dim, 1, size, 1);
+        } else {
+          tf2::kernels::convert<U, T>(
+            data + static_cast<std::size_t>(p) * dim, yi, dim
+          );
+        }
+      }
+    });
+    // Move to the next output
+    offset += dim;
+  }
+}
+
+void tf2::model::check_output(
+  const std::size_t i,
+  const TF_Tensor* tf_output,
+  const std::int32_t size
+) const {
+  const std::int32_t dim = this->outputs_dim[i];
+  const TF_DataType dtype = this->outputs_dtype[i];
+  if (TF_TensorType(tf_output) != dtype) {
+    std::ostringstream message;
+    message << "\nFrom tf2::model::compose_outputs():"
+            << "\n> Datatype of output '" << this->outputs_id[i] << "' ("
+            << cppflow::to_string(TF_TensorType(tf_output)) << ") does not "
+            << "match the graph datatype ("
+            << cppflow::to_string(dtype) << ").";
+    throw std::runtime_error(message.str());
+  }
+  const std::size_t len = TF_DataTypeSize(dtype) * dim * size;
+  if (TF_TensorByteSize(tf_output) != len) {
+    std::ostringstream message;
+    message << "\nFrom tf2::model::compose_outputs():"
+            << "\n> Size of output '" << this->outputs_id[i] << "' does "
+            << "not match the expected shape [" << size << "," << dim << "].";
+    throw std::runtime_error(message.str());
   }
 }
 
 // Calling
 // ====================================
-template <typename T>
+void tf2::model::run_signature(
+  tf2::signature& sig,
+  TF_Status* status
+) {
+  TF_Session* session = this->tfmodel->get_session();
+  tf2::profiler* prof = this->prof.get();
+  const auto t0 = tf2::metrics::clock::now();
+  if (!prof || !prof->sample()) {
+    sig.run(session, status);
+    this->stats.observe(tf2::metrics::session_run, t0);
+    return;
+  }
+  // Traced run
+  std::unique_ptr<TF_Buffer, decltype(&TF_DeleteBuffer)> metadata(
+    TF_NewBuffer(), &TF_DeleteBuffer
+  );
+  sig.run(
+    session,
+    sig.inp_val.data(),
+    sig.out_val.data(),
+    status,
+    prof->run_options(),
+    metadata.get()
+  );
+  this->stats.observe(tf2::metrics::session_run, t0);
+  prof->record(this->tfmodel->get_graph(), metadata.get());
+}
+
+void tf2::model::count_call(
+  const std::int32_t nb_pts,
+  const std::size_t value_size,
+  const tf2::metrics::clock::time_point start
+) {
+  const std::uint64_t n = static_cast<std::uint64_t>(nb_pts);
+  this->stats.add_call(
+    n, n * this->inp_tot_dim * value_size, n * this->out_tot_dim * value_size
+  );
+  this->stats.observe(tf2::metrics::call, start);
+}
+
+template <typename T, typename X, typename Y>
 void tf2::model::evaluate(
-  const std::vector<T>& inputs,
-  std::vector<T>& outputs,
-  const std::int32_t nb_pts
+  X inputs,
+  Y outputs,
+  const std::int32_t nb_pts,
+  const std::int32_t start,
+  const std::int32_t size,
+  const std::size_t thread
 ) {
+  tf2::signature& sig = this->sigs[thread];
   // Inputs manipulation
-  auto x = tf2::model::compose_inputs<T>(inputs, nb_pts);
-  // Perform inference
-  auto y = (*this->tfmodel)(x, this->outputs_id);
+  const auto t0 = tf2::metrics::clock::now();
+  tf2::model::compose_inputs<T>(
+    inputs, nb_pts, start, size, sig.inp_val.data()
+  );
+  this->stats.observe(tf2::metrics::compose_inputs, t0);
+  cppflow::defer release_inputs([&sig]() {
+    release_tensors(sig.inp_val);
+  });
+  // Perform inference through the prepared signature
+  this->run_signature(sig, this->status[thread].get());
+  cppflow::defer release_outputs([&sig]() {
+    release_tensors(sig.out_val);
+  });
   // Outputs manipulation
-  tf2::model::compose_outputs<T>(outputs, y, nb_pts);
+  const auto t1 = tf2::metrics::clock::now();
+  tf2::model::compose_outputs<T>(
+    outputs, sig.out_val.data(), nb_pts, start, size
+  );
+  this->stats.observe(tf2::metrics::compose_outputs, t1);
 }
 
 template <typename T>
-void tf2::model::call(
+void tf2::model::evaluate(
+  const T* inputs,
+  T* outputs,
+  const std::int32_t nb_pts
+) {
+  const auto t0 = tf2::metrics::clock::now();
+  std::lock_guard<std::mutex> guard(this->call_lock);
+  if (this->remote) {
+    this->remote->call<T>(inputs, outputs, nb_pts);
+  } else {
+    this->evaluate<T>(inputs, outputs, nb_pts, 0, nb_pts, 0);
+  }
+  this->count_call(nb_pts, sizeof(T), t0);
+}
+
+template <typename T>
+void tf2::model::evaluate(
   const std::vector<T>& inputs,
   std::vector<T>& outputs,
   const std::int32_t nb_pts
 ) {
-  if ((this->batch_size < 1) || (this->batch_size > nb_pts)) {
-    this->evaluate<T>(inputs, outputs, nb_pts);
-  } else {
-    if (this->rowmajor) {
-      // Initialize inputs and outputs start/end indices
-      std::int32_t is = 0, ie = 0, os = 0;
-      // Calculate the number of batches
-      std::int32_t size = this->batch_size;
-      std::int32_t nb_batches = nb_pts / size;
-      std::int32_t last_batch_size = nb_pts % size;
-      if (last_batch_size > 0) {
-        nb_batches += 1;
-      }
-      // Initialize batched outputs
-      std::vector<T> yb(size * this->out_tot_dim);
-      // Loop over batches and perform inference
+  this->evaluate<T>(inputs.data(), outputs.data(), nb_pts);
+}
+
+template <typename T, typename X, typename Y>
+void tf2::model::run_pipelined(
+  X inputs,
+  Y outputs,
+  const std::int32_t nb_pts,
+  const std::int32_t size,
+  const std::int32_t nb_batches
+) {
+  const std::int32_t depth = this->pipeline_depth;
+  // Progress of the stages (number of batches composed, run and scattered)
+  std::mutex lock;
+  std::condition_variable progress;
+  std::int32_t composed = 0, ran = 0, scattered = 0;
+  bool failed = false;
+  // Wait for a condition on the progress (false if another stage failed)
+  auto await = [&](auto ready) {
+    std::unique_lock<std::mutex> guard(lock);
+    progress.wait(guard, [&]() { return failed || ready(); });
+    return !failed;
+  };
+  auto advance = [&](std::int32_t& counter) {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      ++counter;
+    }
+    progress.notify_all();
+  };
+  // Release the tensors left over by a failure
+  cppflow::defer release([this, depth]() {
+    for (std::int32_t k = 0; k < depth; ++k) {
+      release_tensors(this->sigs[k].inp_val);
+      release_tensors(this->sigs[k].out_val);
+    }
+  });
+  auto stage = [&](std::size_t s, std::size_t) {
+    try {
       for (std::int32_t i = 0; i < nb_batches; ++i) {
-        if ((last_batch_size > 0) && (i == nb_batches - 1)) {
-          size = last_batch_size;
-          yb.resize(size * this->out_tot_dim);
+        const std::int32_t k = i % depth;
+        const std::int32_t start = i * size;
+        const std::int32_t len = std::min(size, nb_pts - start);
+        tf2::signature& sig = this->sigs[k];
+        if (s == 0) {
+          // Producer: compose batch i once its buffer set is released
+          if (!await([&]() { return i - scattered < depth; })) {
+            return;
+          }
+          const auto t0 = tf2::metrics::clock::now();
+          this->compose_inputs<T>(
+            inputs, nb_pts, start, len, sig.inp_val.data()
+          );
+          this->stats.observe(tf2::metrics::compose_inputs, t0);
+          advance(composed);
+        } else if (s == 1) {
+          // Runner: perform inference on batch i once composed
+          if (!await([&]() { return composed > i; })) {
+            return;
+          }
+          this->run_signature(sig, this->status[k].get());
+          release_tensors(sig.inp_val);
+          advance(ran);
+        } else {
+          // Consumer: scatter the outputs of batch i once run
+          if (!await([&]() { return ran > i; })) {
+            return;
+          }
+          const auto t0 = tf2::metrics::clock::now();
+          this->compose_outputs<T>(
+            outputs, sig.out_val.data(), nb_pts, start, len
+          );
+          this->stats.observe(tf2::metrics::compose_outputs, t0);
+          release_tensors(sig.out_val);
+          advance(scattered);
         }
-        // Extract the batched inputs
-        ie += size * this->inp_tot_dim;
-        std::vector<T> xb(inputs.begin() + is, inputs.begin() + ie);
-        is = ie;
-        // Perform batched inference
-        this->evaluate<T>(xb, yb, size);
-        // Move the batched outputs back to the main outputs vector
-        std::move(yb.begin(), yb.end(), outputs.begin() + os);
-        os += size * this->out_tot_dim;
       }
+    } catch (...) {
+      // Stop the other stages, the pool reports the error
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        failed = true;
+      }
+      progress.notify_all();
+      throw;
+    }
+  };
+  this->pipe->parallel_for(3, stage);
+}
+
+template <typename T, typename X, typename Y>
+void tf2::model::run_batches(
+  X inputs,
+  Y outputs,
+  const std::int32_t nb_pts
+) {
+  // Adapt the batch size from the measured throughput
+  const bool tune = this->adaptive_batch_size;
+  if (tune) {
+    this->batch_size = this->tuner.next();
+  }
+  const auto t0 = std::chrono::steady_clock::now();
+  if ((this->batch_size < 1) || (this->batch_size > nb_pts)) {
+    this->evaluate<T>(inputs, outputs, nb_pts, 0, nb_pts, 0);
+  } else {
+    // Calculate the number of batches
+    const std::int32_t size = this->batch_size;
+    std::int32_t nb_batches = nb_pts / size;
+    const std::int32_t last_batch_size = nb_pts % size;
+    if (last_batch_size > 0) {
+      nb_batches += 1;
+    }
+    // Perform batched inference on the slices of each input/output
+    // block (contiguous in row-major, strided in column-major)
+    auto batch = [&](std::size_t i, std::size_t thread) {
+      const bool last = (last_batch_size > 0) &&
+        (i == static_cast<std::size_t>(nb_batches - 1));
+      this->evaluate<T>(
+        inputs,
+        outputs,
+        nb_pts,
+        static_cast<std::int32_t>(i) * size,
+        last ? last_batch_size : size,
+        thread
+      );
+    };
+    // Loop over batches, concurrently or pipelined if allowed
+    if (this->pool) {
+      this->pool->parallel_for(nb_batches, batch);
+    } else if (this->pipe && (nb_batches > 1)) {
+      this->run_pipelined<T>(inputs, outputs, nb_pts, size, nb_batches);
     } else {
-      std::ostringstream message;
-      message << "\nFrom tf2::model::call():"
-              << "\n> Column-major ordered input data are "
-              << "currently not supported for batched inference.";
-      throw std::runtime_error(message.str());
+      for (std::int32_t i = 0; i < nb_batches; ++i) {
+        batch(i, 0);
+      }
     }
   }
+  if (tune && (this->batch_size <= nb_pts)) {
+    const std::chrono::duration<double> dt =
+      std::chrono::steady_clock::now() - t0;
+    this->tuner.record(this->batch_size, nb_pts, dt.count());
+  }
+}
+
+template <typename T>
+void tf2::model::call(
+  const T* inputs,
+  T* outputs,
+  const std::int32_t nb_pts
+) {
+  const auto t0 = tf2::metrics::clock::now();
+  std::lock_guard<std::mutex> guard(this->call_lock);
+  if (this->remote) {
+    this->remote->call<T>(inputs, outputs, nb_pts);
+  } else {
+    this->run_batches<T>(inputs, outputs, nb_pts);
+  }
+  this->count_call(nb_pts, sizeof(T), t0);
+}
+
+template <typename T>
+void tf2::model::call(
+  const std::vector<T>& inputs,
+  std::vector<T>& outputs,
+  const std::int32_t nb_pts
+) {
+  this->call<T>(inputs.data(), outputs.data(), nb_pts);
 }
 
 template <typename T>
@@ -275,29 +1267,265 @@ std::vector<std::vector<T>> tf2::model::call(
   const std::vector<std::vector<T>>& inputs,
   const std::int32_t nb_pts
 ) {
-  // Force column-major order
-  this->rowmajor = false;
-  // Flatten inputs
-  auto x = tf2::ops::flatten<T>(inputs, true);
+  // Collect the rows of the inputs and outputs of each point
+  const auto t0 = tf2::metrics::clock::now();
+  const std::size_t nb_pts_ = static_cast<std::size_t>(nb_pts);
+  std::vector<std::vector<T>> outputs(
+    nb_pts_, std::vector<T>(this->out_tot_dim)
+  );
+  std::lock_guard<std::mutex> guard(this->call_lock);
+  if (this->remote) {
+    // Gather the rows into the input blocks, and scatter back the
+    // output blocks, in the data layout of the model
+    auto index = [this, nb_pts](
+      const std::size_t p, const std::int32_t offset,
+      const std::int32_t dim, const std::int32_t j
+    ) {
+      return static_cast<std::size_t>(offset) * nb_pts + (
+        this->rowmajor ? p * dim + j : static_cast<std::size_t>(j) * nb_pts + p
+      );
+    };
+    std::vector<T> x(nb_pts_ * this->inp_tot_dim);
+    std::vector<T> y(nb_pts_ * this->out_tot_dim);
+    auto t1 = tf2::metrics::clock::now();
+    for (std::size_t p = 0; p < nb_pts_; ++p) {
+      std::int32_t offset = 0;
+      for (const std::int32_t dim : this->inputs_dim) {
+        for (std::int32_t j = 0; j < dim; ++j) {
+          x[index(p, offset, dim, j)] = inputs[p][offset + j];
+        }
+        offset += dim;
+      }
+    }
+    this->stats.observe(tf2::metrics::copies, t1);
+    this->remote->call<T>(x.data(), y.data(), nb_pts);
+    t1 = tf2::metrics::clock::now();
+    for (std::size_t p = 0; p < nb_pts_; ++p) {
+      std::int32_t offset = 0;
+      for (const std::int32_t dim : this->outputs_dim) {
+        for (std::int32_t j = 0; j < dim; ++j) {
+          outputs[p][offset + j] = y[index(p, offset, dim, j)];
+        }
+        offset += dim;
+      }
+    }
+    this->stats.observe(tf2::metrics::copies, t1);
+    this->count_call(nb_pts, sizeof(T), t0);
+    return outputs;
+  }
+  const T** x = this->ws->scratch<const T*>(0, nb_pts_);
+  T** y = this->ws->scratch<T*>(1, nb_pts_);
+  for (std::size_t i = 0; i < nb_pts_; ++i) {
+    x[i] = inputs[i].data();
+    y[i] = outputs[i].data();
+  }
   // Perform inference
-  auto y = this->call<T>(x, nb_pts);
-  // Reshape outputs
-  std::vector<std::int32_t> shape = {nb_pts, this->out_tot_dim};
-  return tf2::ops::reshape<T>(y, shape, true);
+  this->run_batches<T>(
+    static_cast<const T* const*>(x), static_cast<T* const*>(y), nb_pts
+  );
+  this->count_call(nb_pts, sizeof(T), t0);
+  return outputs;
+}
+
+template <typename T>
+std::shared_future<void> tf2::model::call_async(
+  const T* inputs,
+  T* outputs,
+  const std::int32_t nb_pts
+) {
+  std::lock_guard<std::mutex> guard(this->async_lock);
+  if (!this->exec) {
+    this->exec = std::unique_ptr<tf2::executor>(new tf2::executor());
+  }
+  // Forget the calls completed successfully (failed ones are kept,
+  // so that `wait` reports their error)
+  this->pending.erase(
+    std::remove_if(
+      this->pending.begin(),
+      this->pending.end(),
+      [](const std::shared_future<void>& f) {
+        if (f.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+          return false;
+        }
+        try {
+          f.get();
+        } catch (...) {
+          return false;
+        }
+        return true;
+      }
+    ),
+    this->pending.end()
+  );
+  // Queue the inference on the caller's arrays
+  std::shared_future<void> result = this->exec->submit(
+    [this, inputs, outputs, nb_pts]() {
+      this->call<T>(inputs, outputs, nb_pts);
+    }
+  );
+  this->pending.push_back(result);
+  return result;
+}
+
+void tf2::model::set_profiling(
+  const std::int32_t period
+) {
+  std::lock_guard<std::mutex> guard(this->call_lock);
+  if (period < 1) {
+    this->prof.reset();
+  } else {
+    this->prof = std::unique_ptr<tf2::profiler>(
+      new tf2::profiler(period)
+    );
+  }
+}
+
+void tf2::model::dump_profile(
+  std::ostream& out
+) {
+  std::lock_guard<std::mutex> guard(this->call_lock);
+  if (!this->prof) {
+    std::ostringstream message;
+    message << "\nFrom tf2::model::dump_profile():"
+            << "\n> Profiling is not enabled.";
+    throw std::runtime_error(message.str());
+  }
+  this->prof->dump(out);
+}
+
+void tf2::model::dump_profile(
+  const std::string& filename
+) {
+  std::ofstream file(filename);
+  if (!file) {
+    std::ostringstream message;
+    message << "\nFrom tf2::model::dump_profile():"
+            << "\n> Unable to open '" << filename << "'.";
+    throw std::runtime_error(message.str());
+  }
+  this->dump_profile(static_cast<std::ostream&>(file));
+}
+
+void tf2::model::reset_profile() {
+  std::lock_guard<std::mutex> guard(this->call_lock);
+  if (this->prof) {
+    this->prof->reset();
+  }
+}
+
+void tf2::model::wait_ready() {
+  if (this->warmup_done.valid()) {
+    this->warmup_done.get();
+  }
+}
+
+void tf2::model::wait() {
+  std::vector<std::shared_future<void>> calls;
+  {
+    std::lock_guard<std::mutex> guard(this->async_lock);
+    calls.swap(this->pending);
+  }
+  // Wait for all the calls, then report the first error
+  std::exception_ptr error;
+  for (const auto &f : calls) {
+    try {
+      f.get();
+    } catch (...) {
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
 }
 
 // Explicit templates instantiation
 // ====================================
 // Single-precision floating-point format
 // ------------------------------------
-template tf2::data::list_tuple_tensor tf2::model::compose_inputs(
-  const std::vector<float>& inputs,
-  const std::int32_t nb_pts
+template void tf2::model::compose_inputs(
+  const float* inputs,
+  const std::int32_t nb_pts,
+  const std::int32_t start,
+  const std::int32_t size,
+  TF_Tensor** tf_inputs
 );
 
 template void tf2::model::compose_outputs(
-  std::vector<float>& outputs,
-  const std::vector<cppflow::tensor>& tf_outputs,
+  float* outputs,
+  TF_Tensor* const* tf_outputs,
+  const std::int32_t nb_pts,
+  const std::int32_t start,
+  const std::int32_t size
+);
+
+template void tf2::model::compose_inputs(
+  const float* const* rows,
+  const std::int32_t nb_pts,
+  const std::int32_t start,
+  const std::int32_t size,
+  TF_Tensor** tf_inputs
+);
+
+template void tf2::model::compose_outputs(
+  float* const* rows,
+  TF_Tensor* const* tf_outputs,
+  const std::int32_t nb_pts,
+  const std::int32_t start,
+  const std::int32_t size
+);
+
+template void tf2::model::evaluate<float>(
+  const float* inputs,
+  float* outputs,
+  const std::int32_t nb_pts,
+  const std::int32_t start,
+  const std::int32_t size,
+  const std::size_t thread
+);
+
+template void tf2::model::evaluate<float>(
+  const float* const* inputs,
+  float* const* outputs,
+  const std::int32_t nb_pts,
+  const std::int32_t start,
+  const std::int32_t size,
+  const std::size_t thread
+);
+
+template void tf2::model::run_pipelined<float>(
+  const float* inputs,
+  float* outputs,
+  const std::int32_t nb_pts,
+  const std::int32_t size,
+  const std::int32_t nb_batches
+);
+
+template void tf2::model::run_pipelined<float>(
+  const float* const* inputs,
+  float* const* outputs,
+  const std::int32_t nb_pts,
+  const std::int32_t size,
+  const std::int32_t nb_batches
+);
+
+template void tf2::model::run_batches<float>(
+  const float* inputs,
+  float* outputs,
+  const std::int32_t nb_pts
+);
+
+template void tf2::model::run_batches<float>(
+  const float* const* inputs,
+  float* const* outputs,
+  const std::int32_t nb_pts
+);
+
+template void tf2::model::evaluate(
+  const float* inputs,
+  float* outputs,
   const std::int32_t nb_pts
 );
 
@@ -307,6 +1535,12 @@ template void tf2::model::evaluate(
   const std::int32_t nb_pts
 );
 
+template void tf2::model::call(
+  const float* inputs,
+  float* outputs,
+  const std::int32_t nb_pts
+);
+
 template void tf2::model::call(
   const std::vector<float>& inputs,
   std::vector<float>& outputs,
@@ -323,16 +1557,95 @@ template std::vector<std::vector<float>> tf2::model::call(
   const std::int32_t nb_pts
 );
 
+template std::shared_future<void> tf2::model::call_async(
+  const float* inputs,
+  float* outputs,
+  const std::int32_t nb_pts
+);
+
 // Double-precision floating-point format
 // ------------------------------------
-template tf2::data::list_tuple_tensor tf2::model::compose_inputs(
-  const std::vector<double>& inputs,
-  const std::int32_t nb_pts
+template void tf2::model::compose_inputs(
+  const double* inputs,
+  const std::int32_t nb_pts,
+  const std::int32_t start,
+  const std::int32_t size,
+  TF_Tensor** tf_inputs
 );
 
 template void tf2::model::compose_outputs(
-  std::vector<double>& outputs,
-  const std::vector<cppflow::tensor>& tf_outputs,
+  double* outputs,
+  TF_Tensor* const* tf_outputs,
+  const std::int32_t nb_pts,
+  const std::int32_t start,
+  const std::int32_t size
+);
+
+template void tf2::model::compose_inputs(
+  const double* const* rows,
+  const std::int32_t nb_pts,
+  const std::int32_t start,
+  const std::int32_t size,
+  TF_Tensor** tf_inputs
+);
+
+template void tf2::model::compose_outputs(
+  double* const* rows,
+  TF_Tensor* const* tf_outputs,
+  const std::int32_t nb_pts,
+  const std::int32_t start,
+  const std::int32_t size
+);
+
+template void tf2::model::evaluate<double>(
+  const double* inputs,
+  double* outputs,
+  const std::int32_t nb_pts,
+  const std::int32_t start,
+  const std::int32_t size,
+  const std::size_t thread
+);
+
+template void tf2::model::evaluate<double>(
+  const double* const* inputs,
+  double* const* outputs,
+  const std::int32_t nb_pts,
+  const std::int32_t start,
+  const std::int32_t size,
+  const std::size_t thread
+);
+
+template void tf2::model::run_pipelined<double>(
+  const double* inputs,
+  double* outputs,
+  const std::int32_t nb_pts,
+  const std::int32_t size,
+  const std::int32_t nb_batches
+);
+
+template void tf2::model::run_pipelined<double>(
+  const double* const* inputs,
+  double* const* outputs,
+  const std::int32_t nb_pts,
+  const std::int32_t size,
+  const std::int32_t nb_batches
+);
+
+template void tf2::model::run_batches<double>(
+  const double* inputs,
+  double* outputs,
+  const std::int32_t nb_pts
+);
+
+template void tf2::model::run_batches<double>(
+  const double* const* inputs,
+  double* const* outputs,
+  const std::int32_t nb_pts
+);
+
+template void tf2::model::evaluate(
+  const double* inputs,
+  double* outputs,
   const std::int32_t nb_pts
 );
 
@@ -342,6 +1655,12 @@ template void tf2::model::evaluate(
   const std::int32_t nb_pts
 );
 
+template void tf2::model::call(
+  const double* inputs,
+  double* outputs,
+  const std::int32_t nb_pts
+);
+
 template void tf2::model::call(
   const std::vector<double>& inputs,
   std::vector<double>& outputs,
@@ -357,3 +1676,9 @@ template std::vector<std::vector<double>> tf2::model::call(
   const std::vector<std::vector<double>>& inputs,
   const std::int32_t nb_pts
 );
+
+template std::shared_future<void> tf2::model::call_async(
+  const double* inputs,
+  double* outputs,
+  const std::int32_t nb_pts
+);
@@ -6,7 +6,15 @@ module tf2_model
 
   private
 
-  public :: init_model, delete_model, call_model, model_type
+  public :: init_model, delete_model, call_model, call_model_async, wait_model, wait_model_ready, &
+            dump_model_profile, get_model_stats, get_batch_size, model_type, model_stats_type
+
+  ! Phases of the metrics (indices of the `model_stats_type` arrays)
+  integer, parameter, public :: phase_compose_inputs = 1
+  integer, parameter, public :: phase_session_run = 2
+  integer, parameter, public :: phase_compose_outputs = 3
+  integer, parameter, public :: phase_copies = 4
+  integer, parameter, public :: phase_call = 5
 
   type model_type
     type(c_ptr) :: object = c_null_ptr
@@ -14,6 +22,19 @@ module tf2_model
     integer(c_int32_t) :: out_tot_dim = 1
   end type model_type
 
+  type, bind(c) :: model_stats_type
+    integer(c_int64_t) :: nb_calls
+    integer(c_int64_t) :: nb_pts
+    integer(c_int64_t) :: bytes_in
+    integer(c_int64_t) :: bytes_out
+    integer(c_int64_t) :: count(5)
+    real(c_double) :: seconds(5)
+    real(c_double) :: p50(5)
+    real(c_double) :: p99(5)
+    integer(c_int64_t) :: zero_copy_inputs
+    integer(c_int64_t) :: unaligned_inputs
+  end type model_stats_type
+
   interface
 
     ! Constructor
@@ -36,6 +57,13 @@ module tf2_model
       integer(c_int32_t) :: out_tot_dim
     end function c_get_out_tot_dim
 
+    ! Batch size
+    function c_get_batch_size(this) result(batch_size) bind(c, name="get_batch_size")
+      import
+      type(c_ptr), value :: this
+      integer(c_int32_t) :: batch_size
+    end function c_get_batch_size
+
     ! Destructor
     subroutine c_delete_model(this) bind(c, name="delete_model")
       import
@@ -59,12 +87,57 @@ module tf2_model
       type(c_ptr), value :: outputs
     end subroutine c_call_model_double
 
+    ! Evaluate asynchronously
+    subroutine c_call_model_float_async(this, nb_pts, inputs, outputs) bind(c, name="call_model_float_async")
+      import
+      type(c_ptr), value :: this
+      integer(c_int32_t) :: nb_pts
+      type(c_ptr), value :: inputs
+      type(c_ptr), value :: outputs
+    end subroutine c_call_model_float_async
+
+    subroutine c_call_model_double_async(this, nb_pts, inputs, outputs) bind(c, name="call_model_double_async")
+      import
+      type(c_ptr), value :: this
+      integer(c_int32_t) :: nb_pts
+      type(c_ptr), value :: inputs
+      type(c_ptr), value :: outputs
+    end subroutine c_call_model_double_async
+
+    subroutine c_wait_model(this) bind(c, name="wait_model")
+      import
+      type(c_ptr), value :: this
+    end subroutine c_wait_model
+
+    subroutine c_wait_model_ready(this) bind(c, name="wait_model_ready")
+      import
+      type(c_ptr), value :: this
+    end subroutine c_wait_model_ready
+
+    ! Profiling
+    subroutine c_dump_model_profile(this, filename) bind(c, name="dump_model_profile")
+      import
+      type(c_ptr), value :: this
+      character(kind=c_char), dimension(*) :: filename
+    end subroutine c_dump_model_profile
+
+    ! Metrics
+    subroutine c_get_model_stats(this, stats) bind(c, name="get_model_stats")
+      import
+      type(c_ptr), value :: this
+      type(model_stats_type), intent(out) :: stats
+    end subroutine c_get_model_stats
+
   end interface
 
   interface call_model
     module procedure :: call_model_float, call_model_double
   end interface
 
+  interface call_model_async
+    module procedure :: call_model_float_async, call_model_double_async
+  end interface
+
   contains
 
   subroutine init_model(inpfile, this)
@@ -77,6 +150,14 @@ module tf2_model
     this%out_tot_dim = c_get_out_tot_dim(this%object)
   end subroutine init_model
 
+  function get_batch_size(this) result(batch_size)
+    ! Declare in-out variables
+    type(model_type), intent(in) :: this
+    integer(c_int32_t) :: batch_size
+    ! Get the number of points per batch
+    batch_size = c_get_batch_size(this%object)
+  end function get_batch_size
+
   subroutine delete_model(this)
     ! Declare in-out variables
     type(model_type), intent(inout) :: this
@@ -106,4 +187,80 @@ module tf2_model
     call c_call_model_double(this%object, nb_pts, c_loc(inputs), c_loc(outputs))
   end subroutine call_model_double
 
+  subroutine call_model_float_async(this, nb_pts, inputs, outputs)
+    ! Declare in-out variables
+    ! (the arrays are passed without copy and accessed until `wait_model`
+    ! returns: they must be contiguous and stay allocated until then)
+    type(model_type), intent(in) :: this
+    integer(c_int32_t), intent(in) :: nb_pts
+    real(c_float), intent(in), target, asynchronous :: inputs(..)
+    real(c_float), intent(inout), target, asynchronous :: outputs(..)
+    ! Check the arrays
+    call check_async_arrays(this, nb_pts, &
+      is_contiguous(inputs), size(inputs), is_contiguous(outputs), size(outputs))
+    ! Queue the model call
+    call c_call_model_float_async(this%object, nb_pts, c_loc(inputs), c_loc(outputs))
+  end subroutine call_model_float_async
+
+  subroutine call_model_double_async(this, nb_pts, inputs, outputs)
+    ! Declare in-out variables
+    ! (the arrays are passed without copy and accessed until `wait_model`
+    ! returns: they must be contiguous and stay allocated until then)
+    type(model_type), intent(in) :: this
+    integer(c_int32_t), intent(in) :: nb_pts
+    real(c_double), intent(in), target, asynchronous :: inputs(..)
+    real(c_double), intent(inout), target, asynchronous :: outputs(..)
+    ! Check the arrays
+    call check_async_arrays(this, nb_pts, &
+      is_contiguous(inputs), size(inputs), is_contiguous(outputs), size(outputs))
+    ! Queue the model call
+    call c_call_model_double_async(this%object, nb_pts, c_loc(inputs), c_loc(outputs))
+  end subroutine call_model_double_async
+
+  subroutine check_async_arrays(this, nb_pts, inp_contiguous, inp_size, out_contiguous, out_size)
+    ! Declare in-out variables
+    type(model_type), intent(in) :: this
+    integer(c_int32_t), intent(in) :: nb_pts
+    logical, intent(in) :: inp_contiguous, out_contiguous
+    integer, intent(in) :: inp_size, out_size
+    ! The call reads and writes flat buffers: reject the strided arrays
+    ! (e.g., sections), which cannot be used without a temporary copy
+    if (.not. (inp_contiguous .and. out_contiguous)) then
+      error stop "call_model_async: the inputs/outputs arrays must be contiguous"
+    end if
+    if ((inp_size < nb_pts*this%inp_tot_dim) .or. (out_size < nb_pts*this%out_tot_dim)) then
+      error stop "call_model_async: the inputs/outputs arrays are too small"
+    end if
+  end subroutine check_async_arrays
+
+  subroutine wait_model(this)
+    ! Declare in-out variables
+    type(model_type), intent(in) :: this
+    ! Wait for the queued model calls
+    call c_wait_model(this%object)
+  end subroutine wait_model
+
+  subroutine wait_model_ready(this)
+    ! Declare in-out variables
+    type(model_type), intent(in) :: this
+    ! Wait for the warm-up runs
+    call c_wait_model_ready(this%object)
+  end subroutine wait_model_ready
+
+  subroutine dump_model_profile(this, filename)
+    ! Declare in-out variables
+    type(model_type), intent(in) :: this
+    character(*), intent(in) :: filename
+    ! Write the profiling tables
+    call c_dump_model_profile(this%object, filename//c_null_char)
+  end subroutine dump_model_profile
+
+  subroutine get_model_stats(this, stats)
+    ! Declare in-out variables
+    type(model_type), intent(in) :: this
+    type(model_stats_type), intent(out) :: stats
+    ! Read the inference metrics
+    call c_get_model_stats(this%object, stats)
+  end subroutine get_model_stats
+
 end module tf2_model
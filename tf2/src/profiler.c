@@ -0,0 +1,248 @@
+#include <algorithm>
+#include "profiler.h"
+#include "utils/proto.h"
+
+namespace {
+
+  // RunOptions, RunMetadata, StepStats, DeviceStepStats
+  // and NodeExecStats fields
+  enum stats_field : std::uint32_t {
+    // > RunOptions
+    trace_level = 1,
+    // > RunMetadata
+    step_stats = 1,
+    // > StepStats
+    dev_stats = 1,
+    // > DeviceStepStats
+    node_stats = 2,
+    // > NodeExecStats
+    node_name = 1,
+    all_start_micros = 2,
+    op_start_rel_micros = 3,
+    op_end_rel_micros = 4,
+    all_end_rel_micros = 5,
+    timeline_label = 8,
+    op_start_rel_nanos = 14,
+    op_end_rel_nanos = 15,
+    all_end_rel_nanos = 16
+  };
+
+  // Timings of a node execution [us]
+  struct node_exec {
+    std::string name;
+    std::string label;
+    double op_us = 0.0;
+    double all_us = 0.0;
+  };
+
+  node_exec parse_node_stats(const tf2::proto::field& msg) {
+    node_exec exec;
+    std::uint64_t op_start[2] = {0, 0}, op_end[2] = {0, 0}, all_end[2] = {0, 0};
+    bool nanos = false;
+    tf2::proto::reader r(msg);
+    tf2::proto::field f;
+    while (r.next(f)) {
+      switch (f.number) {
+        case node_name: exec.name.assign(f.data, f.size); break;
+        case timeline_label: exec.label.assign(f.data, f.size); break;
+        case op_start_rel_micros: op_start[0] = f.value; break;
+        case op_end_rel_micros: op_end[0] = f.value; break;
+        case all_end_rel_micros: all_end[0] = f.value; break;
+        case op_start_rel_nanos: op_start[1] = f.value; nanos = true; break;
+        case op_end_rel_nanos: op_end[1] = f.value; nanos = true; break;
+        case all_end_rel_nanos: all_end[1] = f.value; nanos = true; break;
+        default: break;
+      }
+    }
+    // Prefer the nanoseconds timings, when reported
+    const int k = nanos ? 1 : 0;
+    const double scale = nanos ? 1.0e-3 : 1.0;
+    if (op_end[k] > op_start[k]) {
+      exec.op_us = (op_end[k] - op_start[k]) * scale;
+    }
+    exec.all_us = all_end[k] * scale;
+    return exec;
+  }
+
+  // Type of a node: from the graph, or else from its timeline
+  // label ("<name> = <type>(<inputs>)"), e.g., for the nodes
+  // of the functions called by the graph
+  std::string node_type(TF_Graph* graph, const node_exec& exec) {
+    TF_Operation* op = TF_GraphOperationByName(graph, exec.name.c_str());
+    if (op != nullptr) {
+      return TF_OperationOpType(op);
+    }
+    const std::size_t eq = exec.label.find(" = ");
+    if (eq != std::string::npos) {
+      const std::size_t start = eq + 3;
+      const std::size_t stop = exec.label.find('(', start);
+      return exec.label.substr(start, stop - start);
+    }
+    return "?";
+  }
+
+  void sort_by_time(std::vector<tf2::profiler::entry>& entries) {
+    std::sort(
+      entries.begin(),
+      entries.end(),
+      [](const tf2::profiler::entry& a, const tf2::profiler::entry& b) {
+        return a.op_us > b.op_us;
+      }
+    );
+  }
+
+} // namespace
+
+
+// Constructor
+// ====================================
+tf2::profiler::profiler(
+  const std::int32_t period,
+  const level trace_level
+) : period(period), options(TF_NewBuffer(), &TF_DeleteBuffer) {
+  if (period < 1) {
+    std::ostringstream message;
+    message << "\nFrom tf2::profiler::profiler():"
+            << "\n> The profiling period must be positive.";
+    throw std::invalid_argument(message.str());
+  }
+  // Serialized RunOptions, owned by the buffer
+  std::string proto;
+  tf2::proto::write_int(proto, ::trace_level, trace_level);
+  char* data = new char[proto.size()];
+  std::copy(proto.begin(), proto.end(), data);
+  this->options->data = data;
+  this->options->length = proto.size();
+  this->options->data_deallocator = [](void* data, std::size_t) {
+    delete[] static_cast<char*>(data);
+  };
+}
+
+// Sampling
+// ====================================
+bool tf2::profiler::sample() {
+  return (this->nb_runs.fetch_add(1, std::memory_order_relaxed) %
+    static_cast<std::uint64_t>(this->period)) == 0;
+}
+
+void tf2::profiler::record(
+  TF_Graph* graph,
+  const TF_Buffer* metadata
+) {
+  // Collect the node executions of all the devices
+  std::vector<node_exec> execs;
+  tf2::proto::reader run(metadata->data, metadata->length);
+  tf2::proto::field f1, f2, f3;
+  while (run.next(f1)) {
+    if ((f1.number != step_stats) || (f1.data == nullptr)) continue;
+    tf2::proto::reader step(f1);
+    while (step.next(f2)) {
+      if ((f2.number != dev_stats) || (f2.data == nullptr)) continue;
+      tf2::proto::reader dev(f2);
+      while (dev.next(f3)) {
+        if ((f3.number != node_stats) || (f3.data == nullptr)) continue;
+        execs.push_back(parse_node_stats(f3));
+      }
+    }
+  }
+  // Aggregate them
+  std::lock_guard<std::mutex> guard(this->lock);
+  this->traced++;
+  for (const auto &exec : execs) {
+    auto it = this->table.find(exec.name);
+    if (it == this->table.end()) {
+      entry e;
+      e.name = exec.name;
+      e.type = node_type(graph, exec);
+      it = this->table.emplace(exec.name, e).first;
+    }
+    it->second.count++;
+    it->second.op_us += exec.op_us;
+    it->second.all_us += exec.all_us;
+  }
+}
+
+// Tables
+// ====================================
+std::vector<tf2::profiler::entry> tf2::profiler::nodes() const {
+  std::vector<entry> entries;
+  {
+    std::lock_guard<std::mutex> guard(this->lock);
+    for (const auto &item : this->table) {
+      entries.push_back(item.second);
+    }
+  }
+  sort_by_time(entries);
+  return entries;
+}
+
+std::vector<tf2::profiler::entry> tf2::profiler::types() const {
+  std::map<std::string, entry> by_type;
+  for (const auto &node : this->nodes()) {
+    entry& e = by_type[node.type];
+    e.type = node.type;
+    e.count += node.count;
+    e.op_us += node.op_us;
+    e.all_us += node.all_us;
+  }
+  std::vector<entry> entries;
+  for (const auto &item : by_type) {
+    entries.push_back(item.second);
+  }
+  sort_by_time(entries);
+  return entries;
+}
+
+std::size_t tf2::profiler::nb_traced() const {
+  std::lock_guard<std::mutex> guard(this->lock);
+  return this->traced;
+}
+
+void tf2::profiler::dump(std::ostream& out) const {
+  const std::vector<entry> nodes = this->nodes();
+  const std::vector<entry> types = this->types();
+  const std::size_t nb_runs = this->nb_traced();
+  const std::size_t runs = std::max<std::size_t>(nb_runs, 1);
+  const double n = static_cast<double>(runs);
+  double total = 0.0;
+  for (const auto &t : types) {
+    total += t.op_us;
+  }
+  total = std::max(total, 1.0e-12);
+  out << "# tf2 profile: " << nb_runs << " traced session runs"
+      << " (one every " << this->period << ")\n"
+      << "# Times are averaged per traced run [us]\n";
+  // Per operation type
+  out << "\n# Operation types\n"
+      << std::left << std::setw(32) << "type"
+      << std::right << std::setw(10) << "count"
+      << std::setw(14) << "op_time"
+      << std::setw(10) << "share\n";
+  for (const auto &t : types) {
+    out << std::left << std::setw(32) << t.type
+        << std::right << std::setw(10) << t.count / runs
+        << std::setw(14) << std::fixed << std::setprecision(2) << t.op_us / n
+        << std::setw(8) << std::setprecision(1) << 100.0 * t.op_us / total
+        << " %\n";
+  }
+  // Per graph node
+  out << "\n# Nodes\n"
+      << std::left << std::setw(48) << "node"
+      << std::setw(32) << "type"
+      << std::right << std::setw(14) << "op_time"
+      << std::setw(14) << "all_time" << "\n";
+  for (const auto &e : nodes) {
+    out << std::left << std::setw(48) << e.name
+        << std::setw(32) << e.type
+        << std::right << std::fixed << std::setprecision(2)
+        << std::setw(14) << e.op_us / n
+        << std::setw(14) << e.all_us / n << "\n";
+  }
+  out << std::defaultfloat;
+}
+
+void tf2::profiler::reset() {
+  std::lock_guard<std::mutex> guard(this->lock);
+  this->traced = 0;
+  this->table.clear();
+}
@@ -0,0 +1,79 @@
+#include <set>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <filesystem>
+#include <condition_variable>
+#include "registry.h"
+
+namespace {
+
+  // Loaded models, keyed by {resolved path, session configuration,
+  // format}
+  using model_key = std::tuple<std::string, std::string, int>;
+
+  std::mutex lock;
+  std::map<model_key, std::weak_ptr<cppflow::model>> models;
+
+  // Models being loaded (outside of the lock), and their completion
+  std::set<model_key> loading;
+  std::condition_variable loaded;
+
+} // namespace
+
+
+// Models
+// ====================================
+std::shared_ptr<cppflow::model> tf2::registry::acquire(
+  const std::string& path_to_model,
+  const std::string& config,
+  const cppflow::model::TYPE type
+) {
+  const model_key key = {
+    std::filesystem::weakly_canonical(path_to_model).string(),
+    config,
+    static_cast<int>(type)
+  };
+  std::unique_lock<std::mutex> guard(lock);
+  // Wait for another caller loading the same model
+  loaded.wait(guard, [&key]() { return loading.count(key) == 0; });
+  // Forget the models released since the last call
+  for (auto it = models.begin(); it != models.end();) {
+    it = it->second.expired() ? models.erase(it) : std::next(it);
+  }
+  // Share the model if already loaded
+  auto it = models.find(key);
+  if (it != models.end()) {
+    if (std::shared_ptr<cppflow::model> mdl = it->second.lock()) {
+      return mdl;
+    }
+  }
+  // Load the model without blocking the other models
+  loading.insert(key);
+  guard.unlock();
+  std::shared_ptr<cppflow::model> mdl;
+  try {
+    mdl = std::shared_ptr<cppflow::model>(
+      new cppflow::model(path_to_model, type, config)
+    );
+  } catch (...) {
+    guard.lock();
+    loading.erase(key);
+    loaded.notify_all();
+    throw;
+  }
+  guard.lock();
+  loading.erase(key);
+  models[key] = mdl;
+  loaded.notify_all();
+  return mdl;
+}
+
+std::size_t tf2::registry::nb_models() {
+  std::lock_guard<std::mutex> guard(lock);
+  std::size_t n = 0;
+  for (const auto &item : models) {
+    n += !item.second.expired();
+  }
+  return n;
+}
@@ -0,0 +1,441 @@
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <nlohmann/json.hpp>
+#include "server.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+  // Copy `count` points between two sets of input/output blocks
+  // holding `src_pts` and `dst_pts` points
+  template <typename T>
+  void copy_points(
+    const T* src,
+    T* dst,
+    const std::vector<std::int32_t>& dims,
+    const std::size_t src_pts,
+    const std::size_t dst_pts,
+    const std::size_t src_start,
+    const std::size_t dst_start,
+    const std::size_t count,
+    const bool rowmajor
+  ) {
+    std::size_t offset = 0;
+    for (const std::size_t dim : dims) {
+      const T* a = src + offset * src_pts;
+      T* b = dst + offset * dst_pts;
+      if (rowmajor) {
+        std::memcpy(
+          b + dst_start * dim, a + src_start * dim, count * dim * sizeof(T)
+        );
+      } else {
+        for (std::size_t j = 0; j < dim; ++j) {
+          std::memcpy(
+            b + j * dst_pts + dst_start,
+            a + j * src_pts + src_start,
+            count * sizeof(T)
+          );
+        }
+      }
+      offset += dim;
+    }
+  }
+
+} // namespace
+
+
+// Constructor
+// ====================================
+tf2::server::server(
+  const std::vector<std::string>& model_dirs,
+  const std::string& socket_path,
+  const std::int32_t max_batch_pts,
+  const std::int32_t batch_window_us
+) : socket_path(socket_path),
+    max_batch_pts(max_batch_pts),
+    batch_window_us(batch_window_us) {
+  if (model_dirs.empty()) {
+    std::ostringstream message;
+    message << "\nFrom tf2::server::server():"
+            << "\n> At least one model directory must be given.";
+    throw std::invalid_argument(message.str());
+  }
+  for (const std::string& dir : model_dirs) {
+    this->model_dirs.push_back(std::filesystem::weakly_canonical(dir));
+  }
+  this->listen_fd = tf2::ipc::listen(socket_path);
+}
+
+// Destructor
+// ====================================
+tf2::server::~server() {
+  this->stop();
+  // Disconnect the clients
+  {
+    std::unique_lock<std::mutex> guard(this->lock);
+    for (const int fd : this->clients) {
+      ::shutdown(fd, SHUT_RDWR);
+    }
+    this->idle.wait(guard, [this]() { return this->nb_sessions == 0; });
+  }
+  // Stop the batching threads
+  for (auto &item : this->models) {
+    hosted& h = *item.second;
+    {
+      std::lock_guard<std::mutex> guard(h.lock);
+      h.stop = true;
+    }
+    h.wake.notify_all();
+    h.dispatcher.join();
+  }
+  ::close(this->listen_fd);
+  ::unlink(this->socket_path.c_str());
+}
+
+// Clients
+// ====================================
+void tf2::server::run() {
+  while (!this->stopping) {
+    const int fd = ::accept4(this->listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) {
+      if ((errno == EINTR) || (errno == ECONNABORTED)) {
+        continue;
+      }
+      break;
+    }
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->clients.push_back(fd);
+    this->nb_sessions++;
+    std::thread(&tf2::server::serve, this, fd).detach();
+  }
+}
+
+void tf2::server::stop() {
+  this->stopping = true;
+  ::shutdown(this->listen_fd, SHUT_RDWR);
+}
+
+tf2::server::hosted& tf2::server::open(
+  const std::string& inpfile
+) {
+  const std::string key = std::filesystem::weakly_canonical(inpfile).string();
+  this->check_path(key);
+  // Find the model, or insert a placeholder to be loaded by this client
+  std::shared_ptr<hosted> h;
+  bool owner = false;
+  {
+    std::lock_guard<std::mutex> guard(this->lock);
+    auto it = this->models.find(key);
+    if (it == this->models.end()) {
+      it = this->models.emplace(key, std::make_shared<hosted>()).first;
+      owner = true;
+    }
+    h = it->second;
+  }
+  if (owner) {
+    // Load the model in this process, whatever its backend (without
+    // the environment variables and metrics file of the client)
+    std::unique_ptr<tf2::model> mdl;
+    std::exception_ptr error;
+    try {
+      // Check the model path before loading it
+      std::ifstream file(key);
+      const json inputs = json::parse(file);
+      this->check_path(inputs.at("path_to_model").get<std::string>());
+      mdl = std::unique_ptr<tf2::model>(
+        new tf2::model(key, tf2::backend::hosted)
+      );
+    } catch (...) {
+      error = std::current_exception();
+    }
+    if (error) {
+      // Let the next clients retry
+      std::lock_guard<std::mutex> guard(this->lock);
+      this->models.erase(key);
+    }
+    {
+      std::lock_guard<std::mutex> guard(h->lock);
+      h->mdl = std::move(mdl);
+      h->load_error = error;
+      h->loaded = true;
+      if (!error) {
+        h->dispatcher = std::thread(
+          &tf2::server::dispatch, this, std::ref(*h)
+        );
+      }
+    }
+    h->ready.notify_all();
+  }
+  // Wait for the model to be loaded
+  std::unique_lock<std::mutex> guard(h->lock);
+  h->ready.wait(guard, [&h]() { return h->loaded; });
+  if (h->load_error) {
+    std::rethrow_exception(h->load_error);
+  }
+  h->nb_clients++;
+  // The loaded models stay in `models` until the server stops
+  return *h;
+}
+
+void tf2::server::check_path(
+  const std::string& path
+) const {
+  const std::filesystem::path resolved = std::filesystem::weakly_canonical(
+    path
+  );
+  for (const std::filesystem::path& dir : this->model_dirs) {
+    const std::filesystem::path rel = resolved.lexically_relative(dir);
+    if (!rel.empty() && (*rel.begin() != "..")) {
+      return;
+    }
+  }
+  throw std::invalid_argument(
+    "'" + path + "' is not within the model directories of the daemon."
+  );
+}
+
+void tf2::server::serve(
+  const int fd
+) {
+  hosted* h = nullptr;
+  std::unique_ptr<tf2::ipc::shared_memory> shm;
+  try {
+    while (true) {
+      tf2::ipc::request req;
+      tf2::ipc::recv_all(fd, &req, sizeof(req));
+      std::string payload(req.length, '\0');
+      tf2::ipc::recv_all(fd, &payload[0], payload.size());
+      // Run the request, reporting its errors to the client
+      tf2::ipc::reply rep{0, 0};
+      std::string answer;
+      try {
+        switch (req.op) {
+          case tf2::ipc::open: {
+            if (h != nullptr) {
+              throw std::invalid_argument("A model is already open.");
+            }
+            h = &this->open(payload);
+            std::vector<std::int32_t> dims = {
+              static_cast<std::int32_t>(h->mdl->inputs_dim.size()),
+              static_cast<std::int32_t>(h->mdl->outputs_dim.size())
+            };
+            dims.insert(
+              dims.end(), h->mdl->inputs_dim.begin(), h->mdl->inputs_dim.end()
+            );
+            dims.insert(
+              dims.end(), h->mdl->outputs_dim.begin(), h->mdl->outputs_dim.end()
+            );
+            answer.assign(
+              reinterpret_cast<const char*>(dims.data()),
+              dims.size() * sizeof(std::int32_t)
+            );
+            break;
+          }
+          case tf2::ipc::map:
+            shm.reset();
+            shm = std::unique_ptr<tf2::ipc::shared_memory>(
+              new tf2::ipc::shared_memory(payload, req.offset, false)
+            );
+            break;
+          case tf2::ipc::call:
+            if ((h == nullptr) || !shm) {
+              throw std::invalid_argument(
+                "No model open or no shared memory mapped."
+              );
+            }
+            this->call(*h, *shm, req);
+            break;
+          default:
+            throw std::invalid_argument("Unknown request.");
+        }
+      } catch (const std::exception& e) {
+        std::ostringstream message;
+        message << "\nFrom tf2::server::serve() (tf2d daemon):" << e.what();
+        answer = message.str();
+        rep.status = 1;
+      }
+      rep.length = static_cast<std::uint32_t>(answer.size());
+      tf2::ipc::send_all(fd, &rep, sizeof(rep));
+      tf2::ipc::send_all(fd, answer.data(), answer.size());
+    }
+  } catch (const std::exception&) {
+    // Disconnected client
+  }
+  if (h != nullptr) {
+    std::lock_guard<std::mutex> guard(h->lock);
+    h->nb_clients--;
+  }
+  std::lock_guard<std::mutex> guard(this->lock);
+  this->clients.erase(
+    std::find(this->clients.begin(), this->clients.end(), fd)
+  );
+  ::close(fd);
+  if (--this->nb_sessions == 0) {
+    this->idle.notify_all();
+  }
+}
+
+// Batching
+// ====================================
+void tf2::server::call(
+  hosted& h,
+  const tf2::ipc::shared_memory& shm,
+  const tf2::ipc::request& req
+) {
+  if ((req.dtype_size != sizeof(float)) && (req.dtype_size != sizeof(double))) {
+    throw std::invalid_argument("Unsupported datatype.");
+  }
+  // Check that the inputs and outputs fit in the segment, without
+  // computing any size which could wrap around (the request is
+  // controlled by the client)
+  const std::string out_of_segment =
+    "Payload out of the shared memory segment.";
+  if ((req.nb_pts < 0) || (req.offset > shm.size())) {
+    throw std::invalid_argument(out_of_segment);
+  }
+  const std::size_t nb_pts = static_cast<std::size_t>(req.nb_pts);
+  const std::size_t inp_pt_size = static_cast<std::size_t>(
+    h.mdl->inp_tot_dim
+  ) * req.dtype_size;
+  const std::size_t out_pt_size = static_cast<std::size_t>(
+    h.mdl->out_tot_dim
+  ) * req.dtype_size;
+  std::size_t available = shm.size() - req.offset;
+  if ((inp_pt_size > 0) && (nb_pts > available / inp_pt_size)) {
+    throw std::invalid_argument(out_of_segment);
+  }
+  const std::size_t inputs_size = nb_pts * inp_pt_size;
+  if (tf2::ipc::align(inputs_size) > available) {
+    throw std::invalid_argument(out_of_segment);
+  }
+  available -= tf2::ipc::align(inputs_size);
+  if ((out_pt_size > 0) && (nb_pts > available / out_pt_size)) {
+    throw std::invalid_argument(out_of_segment);
+  }
+  char* data = static_cast<char*>(shm.data()) + req.offset;
+  job j;
+  j.dtype_size = req.dtype_size;
+  j.inputs = data;
+  j.outputs = data + tf2::ipc::align(inputs_size);
+  j.nb_pts = req.nb_pts;
+  // Queue the call and wait for its batch
+  std::unique_lock<std::mutex> guard(h.lock);
+  h.queue.push_back(&j);
+  h.wake.notify_all();
+  h.done.wait(guard, [&j]() { return j.done; });
+  if (j.error) {
+    std::rethrow_exception(j.error);
+  }
+}
+
+void tf2::server::dispatch(
+  hosted& h
+) {
+  const std::size_t max_pts = static_cast<std::size_t>(this->max_batch_pts);
+  auto queued_pts = [&h]() {
+    std::size_t n = 0;
+    for (const job* j : h.queue) {
+      n += j->nb_pts;
+    }
+    return n;
+  };
+  std::vector<job*> jobs;
+  std::unique_lock<std::mutex> guard(h.lock);
+  while (true) {
+    h.wake.wait(guard, [&h]() { return h.stop || !h.queue.empty(); });
+    if (h.queue.empty()) {
+      return;
+    }
+    // Give the other clients of the model a chance to join the batch
+    if ((h.nb_clients > 1) && (this->batch_window_us > 0)) {
+      h.wake.wait_for(
+        guard,
+        std::chrono::microseconds(this->batch_window_us),
+        [&]() { return h.stop || (queued_pts() >= max_pts); }
+      );
+    }
+    // Take the calls with the same datatype as the first one,
+    // up to the maximum batch size
+    jobs.clear();
+    std::size_t nb_pts = 0;
+    const std::uint32_t dtype_size = h.queue.front()->dtype_size;
+    for (auto it = h.queue.begin(); it != h.queue.end();) {
+      job* j = *it;
+      const bool fits = jobs.empty() || (nb_pts + j->nb_pts <= max_pts);
+      if ((j->dtype_size == dtype_size) && fits) {
+        jobs.push_back(j);
+        nb_pts += j->nb_pts;
+        it = h.queue.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    guard.unlock();
+    std::exception_ptr error;
+    try {
+      if (dtype_size == sizeof(float)) {
+        this->run_jobs<float>(h, jobs);
+      } else {
+        this->run_jobs<double>(h, jobs);
+      }
+    } catch (...) {
+      error = std::current_exception();
+    }
+    guard.lock();
+    for (job* j : jobs) {
+      j->error = error;
+      j->done = true;
+    }
+    h.done.notify_all();
+  }
+}
+
+template <typename T>
+void tf2::server::run_jobs(
+  hosted& h,
+  const std::vector<job*>& jobs
+) {
+  tf2::model& mdl = *h.mdl;
+  if (jobs.size() == 1) {
+    mdl.call<T>(
+      static_cast<const T*>(jobs[0]->inputs),
+      static_cast<T*>(jobs[0]->outputs),
+      jobs[0]->nb_pts
+    );
+    return;
+  }
+  // Merge the calls into one batch
+  std::size_t nb_pts = 0;
+  for (const job* j : jobs) {
+    nb_pts += j->nb_pts;
+  }
+  h.inputs.resize(nb_pts * mdl.inp_tot_dim * sizeof(T));
+  h.outputs.resize(nb_pts * mdl.out_tot_dim * sizeof(T));
+  T* x = reinterpret_cast<T*>(h.inputs.data());
+  T* y = reinterpret_cast<T*>(h.outputs.data());
+  const bool rowmajor = mdl.is_rowmajor();
+  std::size_t start = 0;
+  for (const job* j : jobs) {
+    copy_points(
+      static_cast<const T*>(j->inputs), x, mdl.inputs_dim,
+      j->nb_pts, nb_pts, 0, start, j->nb_pts, rowmajor
+    );
+    start += j->nb_pts;
+  }
+  mdl.call<T>(x, y, static_cast<std::int32_t>(nb_pts));
+  // Scatter the outputs back to the clients
+  start = 0;
+  for (const job* j : jobs) {
+    copy_points(
+      static_cast<const T*>(y), static_cast<T*>(j->outputs), mdl.outputs_dim,
+      nb_pts, j->nb_pts, start, 0, j->nb_pts, rowmajor
+    );
+    start += j->nb_pts;
+  }
+}
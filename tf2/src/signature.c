@@ -0,0 +1,79 @@
+#include <cppflow/cppflow.h>
+#include "signature.h"
+
+
+// Constructor
+// ====================================
+tf2::signature::signature(
+  TF_Graph* graph,
+  const std::vector<std::string>& inputs_id,
+  const std::vector<std::string>& outputs_id
+) {
+  // Resolve endpoints
+  for (const auto &i_id : inputs_id) {
+    this->inputs.push_back(tf2::signature::resolve(graph, i_id));
+  }
+  for (const auto &o_id : outputs_id) {
+    this->outputs.push_back(tf2::signature::resolve(graph, o_id));
+  }
+  // Allocate tensor handles
+  this->inp_val.assign(this->inputs.size(), nullptr);
+  this->out_val.assign(this->outputs.size(), nullptr);
+}
+
+TF_Output tf2::signature::resolve(
+  TF_Graph* graph,
+  const std::string& id
+) {
+  const auto [op_name, op_idx] = cppflow::parse_name(id);
+  TF_Output endpoint;
+  endpoint.oper = TF_GraphOperationByName(graph, op_name.c_str());
+  endpoint.index = op_idx;
+  if (!endpoint.oper) {
+    std::ostringstream message;
+    message << "\nFrom tf2::signature::resolve():"
+            << "\n> Operation '" << op_name << "' not found in the graph!";
+    throw std::runtime_error(message.str());
+  }
+  return endpoint;
+}
+
+// Calling
+// ====================================
+void tf2::signature::run(
+  TF_Session* session,
+  TF_Tensor* const* inp_val,
+  TF_Tensor** out_val,
+  TF_Status* status,
+  const TF_Buffer* run_options,
+  TF_Buffer* run_metadata
+) const {
+  TF_SessionRun(
+    session,
+    // RunOptions
+    run_options,
+    // Input tensors
+    this->inputs.data(),
+    inp_val,
+    static_cast<int>(this->inputs.size()),
+    // Output tensors
+    this->outputs.data(),
+    out_val,
+    static_cast<int>(this->outputs.size()),
+    // Target operations
+    nullptr,
+    0,
+    // RunMetadata
+    run_metadata,
+    // Output status
+    status
+  );
+  cppflow::status_check(status);
+}
+
+void tf2::signature::run(
+  TF_Session* session,
+  TF_Status* status
+) {
+  this->run(session, this->inp_val.data(), this->out_val.data(), status);
+}
@@ -0,0 +1,105 @@
+#include "thread_pool.h"
+
+
+// Constructor
+// ====================================
+tf2::thread_pool::thread_pool(
+  const std::size_t nb_threads
+) {
+  for (std::size_t t = 1; t < nb_threads; ++t) {
+    this->workers.emplace_back(&tf2::thread_pool::loop, this, t);
+  }
+}
+
+// Destructor
+// ====================================
+tf2::thread_pool::~thread_pool() {
+  {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->stop = true;
+  }
+  this->wake.notify_all();
+  for (auto &worker : this->workers) {
+    worker.join();
+  }
+}
+
+// Loops
+// ====================================
+void tf2::thread_pool::run(
+  const std::size_t n,
+  task_fn fn,
+  void* ctx
+) {
+  // Run serially if there is nothing to share
+  if (this->workers.empty() || n < 2) {
+    for (std::size_t i = 0; i < n; ++i) {
+      fn(ctx, i, 0);
+    }
+    return;
+  }
+  // Publish the loop and wake up the workers
+  {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->fn = fn;
+    this->ctx = ctx;
+    this->nb_iters = n;
+    this->next = 0;
+    this->nb_busy = this->workers.size();
+    this->generation++;
+  }
+  this->wake.notify_all();
+  // Take part in the loop
+  this->work(0);
+  // Wait for the workers to complete
+  std::unique_lock<std::mutex> guard(this->lock);
+  this->done.wait(guard, [this]() { return this->nb_busy == 0; });
+  this->fn = nullptr;
+  this->ctx = nullptr;
+  if (this->error) {
+    std::exception_ptr error = this->error;
+    this->error = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+void tf2::thread_pool::work(
+  const std::size_t t
+) {
+  for (std::size_t i = this->next++; i < this->nb_iters; i = this->next++) {
+    try {
+      this->fn(this->ctx, i, t);
+    } catch (...) {
+      std::lock_guard<std::mutex> guard(this->lock);
+      if (!this->error) {
+        this->error = std::current_exception();
+      }
+    }
+  }
+}
+
+void tf2::thread_pool::loop(
+  const std::size_t t
+) {
+  std::size_t seen = 0;
+  while (true) {
+    // Wait for a new loop
+    {
+      std::unique_lock<std::mutex> guard(this->lock);
+      this->wake.wait(guard, [this, seen]() {
+        return this->stop || this->generation != seen;
+      });
+      if (this->stop) {
+        return;
+      }
+      seen = this->generation;
+    }
+    // Take part in the loop
+    this->work(t);
+    // Notify completion
+    std::lock_guard<std::mutex> guard(this->lock);
+    if (--this->nb_busy == 0) {
+      this->done.notify_one();
+    }
+  }
+}
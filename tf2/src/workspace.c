@@ -0,0 +1,110 @@
+#include <new>
+#include "workspace.h"
+
+
+// Destructor
+// ====================================
+tf2::workspace::~workspace() {
+  for (auto &item : this->pools) {
+    for (void* data : item.second.buffers) {
+      buffer_deleter()(data);
+    }
+  }
+}
+
+// Tensors pool
+// ====================================
+TF_Tensor* tf2::workspace::new_tensor(
+  const TF_DataType dtype,
+  const std::int64_t* shape,
+  const int nb_dims
+) {
+  // Compute the buffer size and its capacity (the next power of two)
+  std::size_t len = TF_DataTypeSize(dtype);
+  for (int i = 0; i < nb_dims; ++i) {
+    len *= static_cast<std::size_t>(shape[i]);
+  }
+  std::size_t capacity = tf2::workspace::alignment;
+  while (capacity < len) {
+    capacity <<= 1;
+  }
+  // Get the smallest free buffer at least as large as needed,
+  // or allocate a new one in the pool of its capacity
+  void* data = nullptr;
+  pool* p = nullptr;
+  {
+    std::lock_guard<std::mutex> guard(this->lock);
+    auto it = this->pools.lower_bound({dtype, capacity});
+    for (; it != this->pools.end() && it->first.first == dtype; ++it) {
+      if (!it->second.buffers.empty()) {
+        p = &it->second;
+        data = p->buffers.back();
+        p->buffers.pop_back();
+        this->reuses++;
+        break;
+      }
+    }
+    if (data == nullptr) {
+      it = this->pools.find({dtype, capacity});
+      if (it == this->pools.end()) {
+        it = this->pools.emplace(
+          pool_key{dtype, capacity}, pool{this, capacity, 0, {}}
+        ).first;
+        this->allocs++;
+      }
+      p = &it->second;
+      // Make room for the buffer in the free list beforehand,
+      // so that returning it to the pool never allocates
+      p->nb_buffers++;
+      if (p->buffers.capacity() < p->nb_buffers) {
+        p->buffers.reserve(p->nb_buffers);
+        this->allocs++;
+      }
+    }
+  }
+  if (data == nullptr) {
+    data = this->allocate(capacity);
+  }
+  return TF_NewTensor(
+    dtype, shape, nb_dims, data, len, &tf2::workspace::release, p
+  );
+}
+
+void tf2::workspace::trim() {
+  std::lock_guard<std::mutex> guard(this->lock);
+  for (auto &item : this->pools) {
+    pool& p = item.second;
+    for (void* data : p.buffers) {
+      buffer_deleter()(data);
+    }
+    p.nb_buffers -= p.buffers.size();
+    p.buffers.clear();
+  }
+}
+
+void tf2::workspace::release(
+  void* data,
+  std::size_t,
+  void* arg
+) {
+  pool* p = static_cast<pool*>(arg);
+  std::lock_guard<std::mutex> guard(p->owner->lock);
+  p->buffers.push_back(data);
+}
+
+// Memory
+// ====================================
+void* tf2::workspace::allocate(
+  const std::size_t len
+) {
+  this->allocs++;
+  return ::operator new(
+    (len > 0) ? len : 1, std::align_val_t(tf2::workspace::alignment)
+  );
+}
+
+void tf2::workspace::buffer_deleter::operator()(
+  void* data
+) const {
+  ::operator delete(data, std::align_val_t(tf2::workspace::alignment));
+}
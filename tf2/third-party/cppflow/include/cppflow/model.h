@@ -44,6 +44,12 @@
 // C headers
 #include <tensorflow/c/c_api.h>
 
+// C/POSIX headers
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 // C++ headers
 #include <fstream>
 #include <iostream>
@@ -68,9 +74,12 @@ namespace cppflow {
       FROZEN_GRAPH,
     };  // enum TYPE
 
+    // The session is configured with `config`, a serialized
+    // ConfigProto (default configuration if empty)
     explicit model(
       const std::string& filename,
-      const TYPE type = TYPE::SAVED_MODEL
+      const TYPE type = TYPE::SAVED_MODEL,
+      const std::string& config = ""
     );
     model(const model &model) = default;
     model(model &&model) = default;
@@ -80,14 +89,19 @@ namespace cppflow {
     model &operator=(const model &other) = default;
     model &operator=(model &&other) = default;
     std::vector<tensor> operator()(
-      std::vector<std::tuple<std::string, tensor>> inputs,
-      std::vector<std::string> outputs
+      const std::vector<std::tuple<std::string, tensor>>& inputs,
+      const std::vector<std::string>& outputs
     );
     tensor operator()(const tensor& input);
 
     std::vector<std::string> get_operations() const;
     std::vector<int64_t> get_operation_shape(const std::string& operation) const;
 
+    // Raw access to the underlying graph and session, e.g., to resolve
+    // the input/output endpoints once and call TF_SessionRun directly
+    TF_Graph* get_graph() const { return this->graph.get(); }
+    TF_Session* get_session() const { return this->session.get(); }
+
     bool is_cuda_available = false;
     void set_is_cuda_available();
 
@@ -105,13 +119,26 @@ namespace cppflow {
 
 namespace cppflow {
 
-  inline model::model(const std::string &filename, const TYPE type) {
+  inline model::model(
+    const std::string &filename,
+    const TYPE type,
+    const std::string &config
+  ) {
     this->status = {TF_NewStatus(), &TF_DeleteStatus};
     this->graph = {TF_NewGraph(), TF_DeleteGraph};
 
     // Create the session.
     std::unique_ptr<TF_SessionOptions, decltype(&TF_DeleteSessionOptions)>
       session_options = {TF_NewSessionOptions(), TF_DeleteSessionOptions};
+    if (!config.empty()) {
+      TF_SetConfig(
+        session_options.get(),
+        config.data(),
+        config.size(),
+        this->status.get()
+      );
+      status_check(this->status.get());
+    }
 
     auto session_deleter = [this](TF_Session* sess) {
       TF_DeleteSession(sess, this->status.get());
@@ -285,8 +312,8 @@ namespace cppflow {
   }
 
   inline std::vector<tensor> model::operator()(
-    std::vector<std::tuple<std::string, tensor>> inputs,
-    std::vector<std::string> outputs
+    const std::vector<std::tuple<std::string, tensor>>& inputs,
+    const std::vector<std::string>& outputs
   ) {
     std::vector<TF_Output> inp_ops(inputs.size());
     std::vector<TF_Tensor*> inp_val(inputs.size(), nullptr);
@@ -364,35 +391,42 @@ namespace cppflow {
   }
 
   inline TF_Buffer* model::readGraph(const std::string& filename) {
-    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    // Map the file, instead of reading it into a heap buffer and
+    // copying it: the buffer points into the mapping, which is
+    // released with the buffer
+    const int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
 
     // Error opening the file
-    if (!file.is_open()) {
+    if (fd < 0) {
       std::cerr << "Unable to open file: " << filename << std::endl;
       return nullptr;
     }
 
-    // Cursor is at the end to get size
-    auto size = file.tellg();
-    // Move cursor to the beginning
-    file.seekg(0, std::ios::beg);
-
-    // Read
-    auto data = std::make_unique<char[]>(size);
-    file.seekg(0, std::ios::beg);
-    file.read(data.get(), size);
-
-    // Error reading the file
-    if (!file) {
-      std::cerr << "Unable to read the full file: " << filename << std::endl;
+    struct stat info;
+    if ((::fstat(fd, &info) < 0) || (info.st_size <= 0)) {
+      std::cerr << "Unable to read the file size: " << filename << std::endl;
+      ::close(fd);
       return nullptr;
     }
+    const size_t size = static_cast<size_t>(info.st_size);
 
-    // Create tensorflow buffer from read data
-    TF_Buffer* buffer = TF_NewBufferFromString(data.get(), size);
+    void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
 
-    // Close file and remove data
-    file.close();
+    // Error mapping the file
+    if (data == MAP_FAILED) {
+      std::cerr << "Unable to map the file: " << filename << std::endl;
+      return nullptr;
+    }
+    ::madvise(data, size, MADV_SEQUENTIAL);
+
+    // Create tensorflow buffer over the mapping
+    TF_Buffer* buffer = TF_NewBuffer();
+    buffer->data = data;
+    buffer->length = size;
+    buffer->data_deallocator = [](void* data, size_t length) {
+      ::munmap(data, length);
+    };
 
     return buffer;
   }